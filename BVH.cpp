@@ -0,0 +1,680 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The bounding volume hierarchy class
+-------------------------------------------------------------*/
+
+#include "BVH.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+const int SAH_BINS = 16;        //Candidate split planes per axis in the SAH build
+const int MAX_LEAF = 4;         //Most objects in an SAH leaf
+const float NODE_COST = 1.0f;   //Cost of testing a ray against a box...
+const float PRIM_COST = 2.0f;   //...and against an object...
+const float PACK_COST = 4.0f;   //...and against a pack of quadrics
+const int TREELET_SIZE = 7;     //Leaves of a treelet optimised at once
+const int STACK_SIZE = 256;     //Deepest tree closestPt() can walk
+const float BOX_PAD = 1.e-4f;   //Relative padding of boxes, so rounding never loses a hit
+
+//Surface area of a box
+static float area(glm::vec3 lo, glm::vec3 hi)
+{
+    glm::vec3 d = glm::max(hi - lo, glm::vec3(0));
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+//Expected cost of a leaf of 'count' objects, 'quadrics' of which are packed when that is cheaper
+static float leafCost(int count, int quadrics)
+{
+    if (PRIM_COST * quadrics < PACK_COST) return PRIM_COST * count;
+    return PACK_COST * ((quadrics + QUADRIC_LANES - 1) / QUADRIC_LANES) + PRIM_COST * (count - quadrics);
+}
+
+//Calls fn(begin, end) on 'threads' threads, each with a part of [0, count)
+template<class F>
+static void parallelFor(int count, int threads, F fn)
+{
+    threads = std::max(1, std::min(threads, count));
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++)
+        workers.emplace_back(fn, (int)((long)count * t / threads), (int)((long)count * (t + 1) / threads));
+    fn(0, (int)((long)count / threads));
+    for (std::thread& w : workers) w.join();
+}
+
+//Spreads the low 10 bits of v so that there are two zero bits between each
+static uint32_t expandBits(uint32_t v)
+{
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+//30 bit Morton code of a point in the unit cube
+static uint32_t morton(glm::vec3 p)
+{
+    uint32_t x = (uint32_t)glm::clamp(p.x * 1024.0f, 0.0f, 1023.0f);
+    uint32_t y = (uint32_t)glm::clamp(p.y * 1024.0f, 0.0f, 1023.0f);
+    uint32_t z = (uint32_t)glm::clamp(p.z * 1024.0f, 0.0f, 1023.0f);
+    return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+}
+
+static int countLeadingZeros(uint64_t v)
+{
+    return v == 0 ? 64 : __builtin_clzll(v);
+}
+
+//---Builds the tree over 'objects' ------------------------------------------------
+//   threads is the number of threads of the LBVH build (0: one per core), and
+//   treeletPasses the number of restructuring passes applied to it.
+//----------------------------------------------------------------------------------
+void BVH::build(std::vector<SceneObject*>& objects, BVHBuild method, int threads, int treeletPasses)
+{
+    auto start = std::chrono::steady_clock::now();
+    clear();
+    objectCount_ = (int)objects.size();
+    if (objects.empty()) return;
+
+    std::vector<Prim> prims(objects.size());
+    for (int i = 0; i < (int)objects.size(); i++)
+    {
+        objects[i]->bounds(prims[i].lo, prims[i].hi);
+        glm::vec3 pad = BOX_PAD * (glm::max(glm::abs(prims[i].lo), glm::abs(prims[i].hi)) + glm::vec3(1));
+        prims[i].lo -= pad;
+        prims[i].hi += pad;
+        prims[i].centre = 0.5f * (prims[i].lo + prims[i].hi);
+        prims[i].index = i;
+    }
+    stats_.peakBytes = prims.size() * sizeof(Prim);
+
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (method == BVH_SAH)
+    {
+        nodes_.reserve(2 * prims.size());
+        prims_.reserve(prims.size());
+        buildSAH(prims, 0, (int)prims.size());
+        stats_.peakBytes += nodes_.capacity() * sizeof(Node) + prims_.capacity() * sizeof(int);
+    }
+    else buildLBVH(prims, threads, treeletPasses);
+
+    packLeaves(objects);
+    finish();
+    stats_.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (stats_.maxDepth >= STACK_SIZE)
+    {
+        std::cerr << "BVH is " << stats_.maxDepth << " levels deep; objects will be tested one by one" << std::endl;
+        clear();
+    }
+}
+
+//---Top-down binned SAH build of prims[first .. first+count-1] --------------------
+//   Returns the index of the subtree's root.
+//----------------------------------------------------------------------------------
+int BVH::buildSAH(std::vector<Prim>& prims, int first, int count)
+{
+    int nodeIndex = (int)nodes_.size();
+    nodes_.push_back(Node());
+
+    glm::vec3 lo = prims[first].lo, hi = prims[first].hi;
+    glm::vec3 clo = prims[first].centre, chi = prims[first].centre;
+    for (int i = first + 1; i < first + count; i++)
+    {
+        lo = glm::min(lo, prims[i].lo);
+        hi = glm::max(hi, prims[i].hi);
+        clo = glm::min(clo, prims[i].centre);
+        chi = glm::max(chi, prims[i].centre);
+    }
+    nodes_[nodeIndex].lo = lo;
+    nodes_[nodeIndex].hi = hi;
+
+    //Best split over the bins of each axis
+    float bestCost = PRIM_COST * count;
+    int bestAxis = -1, bestBin = 0;
+    float boxArea = area(lo, hi);
+    for (int axis = 0; axis < 3 && count > 1 && boxArea > 0; axis++)
+    {
+        float extent = chi[axis] - clo[axis];
+        if (extent <= 0) continue;
+
+        int binCount[SAH_BINS] = {0};
+        glm::vec3 binLo[SAH_BINS], binHi[SAH_BINS];
+        for (int i = first; i < first + count; i++)
+        {
+            int b = std::min(SAH_BINS - 1, (int)(SAH_BINS * (prims[i].centre[axis] - clo[axis]) / extent));
+            binLo[b] = binCount[b] ? glm::min(binLo[b], prims[i].lo) : prims[i].lo;
+            binHi[b] = binCount[b] ? glm::max(binHi[b], prims[i].hi) : prims[i].hi;
+            binCount[b]++;
+        }
+
+        //Area and count to the right of each plane, then sweep from the left
+        float rightArea[SAH_BINS];
+        int rightCount[SAH_BINS];
+        glm::vec3 rlo, rhi;
+        int n = 0;
+        for (int b = SAH_BINS - 1; b > 0; b--)
+        {
+            if (binCount[b])
+            {
+                rlo = n ? glm::min(rlo, binLo[b]) : binLo[b];
+                rhi = n ? glm::max(rhi, binHi[b]) : binHi[b];
+                n += binCount[b];
+            }
+            rightArea[b] = n ? area(rlo, rhi) : 0;
+            rightCount[b] = n;
+        }
+        glm::vec3 llo, lhi;
+        n = 0;
+        for (int b = 0; b < SAH_BINS - 1; b++)
+        {
+            if (binCount[b])
+            {
+                llo = n ? glm::min(llo, binLo[b]) : binLo[b];
+                lhi = n ? glm::max(lhi, binHi[b]) : binHi[b];
+                n += binCount[b];
+            }
+            if (n == 0 || rightCount[b + 1] == 0) continue;
+            float cost = NODE_COST + PRIM_COST * (n * area(llo, lhi) + rightCount[b + 1] * rightArea[b + 1]) / boxArea;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    int mid;
+    if (bestAxis >= 0)
+    {
+        float extent = chi[bestAxis] - clo[bestAxis];
+        Prim* split = std::partition(&prims[first], &prims[first] + count, [&](const Prim& p) {
+            return std::min(SAH_BINS - 1, (int)(SAH_BINS * (p.centre[bestAxis] - clo[bestAxis]) / extent)) <= bestBin;
+        });
+        mid = (int)(split - &prims[0]);
+    }
+    else if (count > MAX_LEAF)
+    {
+        //Too many objects for a leaf but no useful plane: split at the median
+        int axis = 0;
+        glm::vec3 extent = chi - clo;
+        if (extent.y > extent[axis]) axis = 1;
+        if (extent.z > extent[axis]) axis = 2;
+        mid = first + count / 2;
+        std::nth_element(&prims[first], &prims[mid], &prims[first] + count, [axis](const Prim& a, const Prim& b) {
+            return a.centre[axis] < b.centre[axis];
+        });
+    }
+    else
+    {
+        nodes_[nodeIndex].first = (int)prims_.size();
+        nodes_[nodeIndex].count = count;
+        for (int i = first; i < first + count; i++) prims_.push_back(prims[i].index);
+        return nodeIndex;
+    }
+
+    int left = buildSAH(prims, first, mid - first);
+    int right = buildSAH(prims, mid, first + count - mid);
+    nodes_[nodeIndex].left = left;
+    nodes_[nodeIndex].right = right;
+    nodes_[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+//---Parallel linear BVH build --------------------------------------------------------
+//   The objects are sorted by the Morton code of their centre, with their index
+//     appended to make every key distinct.  Internal node i then covers a range of
+//     keys starting or ending at key i, found independently of the other nodes,
+//     so all of them are built in parallel.  Boxes are filled in bottom-up: the
+//     second thread to reach a node computes its box and carries on upwards.
+//   Internal nodes are nodes_[0 .. n-2] and leaf k is nodes_[n-1+k].
+//----------------------------------------------------------------------------------
+void BVH::buildLBVH(std::vector<Prim>& prims, int threads, int treeletPasses)
+{
+    int n = (int)prims.size();
+
+    //Box of the centres, reduced over the threads
+    std::vector<glm::vec3> partLo(threads, prims[0].centre), partHi(threads, prims[0].centre);
+    std::atomic<int> part(0);
+    parallelFor(n, threads, [&](int begin, int end) {
+        int t = part++;
+        for (int i = begin; i < end; i++)
+        {
+            partLo[t] = glm::min(partLo[t], prims[i].centre);
+            partHi[t] = glm::max(partHi[t], prims[i].centre);
+        }
+    });
+    glm::vec3 clo = partLo[0], chi = partHi[0];
+    for (int t = 1; t < threads; t++)
+    {
+        clo = glm::min(clo, partLo[t]);
+        chi = glm::max(chi, partHi[t]);
+    }
+    glm::vec3 scale = 1.0f / glm::max(chi - clo, glm::vec3(1.e-12f));
+
+    std::vector<uint64_t> keys(n);
+    parallelFor(n, threads, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            keys[i] = ((uint64_t)morton((prims[i].centre - clo) * scale) << 32) | (uint32_t)i;
+    });
+
+    //Sort the keys in chunks, one per thread, then merge pairs of chunks
+    int chunks = std::max(1, std::min(threads, n));
+    std::vector<int> bound(chunks + 1);
+    for (int c = 0; c <= chunks; c++) bound[c] = (int)((long)n * c / chunks);
+    parallelFor(chunks, chunks, [&](int begin, int end) {
+        for (int c = begin; c < end; c++) std::sort(&keys[0] + bound[c], &keys[0] + bound[c + 1]);
+    });
+    for (int width = 1; width < chunks; width *= 2)
+    {
+        int pairs = (chunks + 2 * width - 1) / (2 * width);
+        parallelFor(pairs, pairs, [&](int begin, int end) {
+            for (int p = begin; p < end; p++)
+            {
+                int c = p * 2 * width;
+                if (c + width >= chunks) continue;
+                std::inplace_merge(&keys[0] + bound[c], &keys[0] + bound[c + width],
+                                   &keys[0] + bound[std::min(chunks, c + 2 * width)]);
+            }
+        });
+    }
+
+    nodes_.resize(2 * n - 1);
+    prims_.resize(n);
+    std::vector<int> parent(2 * n - 1, -1);
+    std::vector<int> leafCount(2 * n - 1, 1);
+    std::vector<float> cost(2 * n - 1);
+
+    //Leaves, one object each
+    parallelFor(n, threads, [&](int begin, int end) {
+        for (int k = begin; k < end; k++)
+        {
+            const Prim& p = prims[(uint32_t)keys[k]];
+            Node& leaf = nodes_[n - 1 + k];
+            leaf.lo = p.lo;
+            leaf.hi = p.hi;
+            leaf.first = k;
+            leaf.count = 1;
+            prims_[k] = p.index;
+            cost[n - 1 + k] = PRIM_COST * area(p.lo, p.hi);
+        }
+    });
+
+    //Internal nodes
+    auto delta = [&](int i, int j) {
+        if (j < 0 || j >= n) return -1;
+        return countLeadingZeros(keys[i] ^ keys[j]);
+    };
+    parallelFor(n - 1, threads, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            int d = (delta(i, i + 1) > delta(i, i - 1)) ? 1 : -1;
+
+            //Other end of the range covered by node i
+            int dmin = delta(i, i - d);
+            int lmax = 2;
+            while (delta(i, i + lmax * d) > dmin) lmax *= 2;
+            int l = 0;
+            for (int t = lmax / 2; t >= 1; t /= 2)
+                if (delta(i, i + (l + t) * d) > dmin) l += t;
+            int j = i + l * d;
+
+            //Split position: the last key sharing more leading bits with key i than key j does
+            int dnode = delta(i, j);
+            int s = 0;
+            for (int div = 2; ; div *= 2)
+            {
+                int t = (l + div - 1) / div;
+                if (delta(i, i + (s + t) * d) > dnode) s += t;
+                if (t <= 1) break;
+            }
+            int split = i + s * d + std::min(d, 0);
+
+            Node& node = nodes_[i];
+            node.left = (std::min(i, j) == split) ? n - 1 + split : split;
+            node.right = (std::max(i, j) == split + 1) ? n + split : split + 1;
+            node.count = 0;
+            parent[node.left] = i;
+            parent[node.right] = i;
+        }
+    });
+
+    //Bottom-up passes: the first fills in the boxes, the others restructure treelets
+    std::vector<std::atomic<int>> visits(std::max(1, n - 1));
+    stats_.peakBytes += keys.size() * sizeof(uint64_t) + nodes_.size() * sizeof(Node) + prims_.size() * sizeof(int)
+                      + parent.size() * sizeof(int) + leafCount.size() * sizeof(int) + cost.size() * sizeof(float)
+                      + visits.size() * sizeof(std::atomic<int>);
+    for (int pass = 0; pass <= treeletPasses && n > 1; pass++)
+    {
+        int minLeaves = TREELET_SIZE << std::max(0, pass - 1);    //Later passes only visit larger subtrees
+        for (std::atomic<int>& v : visits) v.store(0);
+        parallelFor(n, threads, [&](int begin, int end) {
+            for (int k = begin; k < end; k++)
+            {
+                int node = parent[n - 1 + k];
+                while (node >= 0 && visits[node].fetch_add(1, std::memory_order_acq_rel) == 1)
+                {
+                    Node& p = nodes_[node];
+                    if (pass == 0)
+                    {
+                        p.lo = glm::min(nodes_[p.left].lo, nodes_[p.right].lo);
+                        p.hi = glm::max(nodes_[p.left].hi, nodes_[p.right].hi);
+                        leafCount[node] = leafCount[p.left] + leafCount[p.right];
+                        cost[node] = NODE_COST * area(p.lo, p.hi) + cost[p.left] + cost[p.right];
+                    }
+                    else if (leafCount[node] >= minLeaves)
+                    {
+                        //Grow the treelet by opening its largest internal leaf
+                        int leaves[TREELET_SIZE] = {p.left, p.right};
+                        int inner[TREELET_SIZE];
+                        int nLeaves = 2, nInner = 0;
+                        while (nLeaves < TREELET_SIZE)
+                        {
+                            int best = -1;
+                            float bestArea = -1;
+                            for (int m = 0; m < nLeaves; m++)
+                            {
+                                const Node& c = nodes_[leaves[m]];
+                                if (c.count == 0 && area(c.lo, c.hi) > bestArea)
+                                {
+                                    best = m;
+                                    bestArea = area(c.lo, c.hi);
+                                }
+                            }
+                            if (best < 0) break;
+                            int opened = leaves[best];
+                            inner[nInner++] = opened;
+                            leaves[best] = nodes_[opened].left;
+                            leaves[nLeaves++] = nodes_[opened].right;
+                        }
+
+                        //Cheapest tree over every subset of the treelet's leaves
+                        const int subsets = 1 << nLeaves;
+                        glm::vec3 slo[1 << TREELET_SIZE], shi[1 << TREELET_SIZE];
+                        float scost[1 << TREELET_SIZE];
+                        int spart[1 << TREELET_SIZE];
+                        for (int s = 1; s < subsets; s++)
+                        {
+                            int m = __builtin_ctz(s);
+                            int rest = s & (s - 1);
+                            const Node& c = nodes_[leaves[m]];
+                            slo[s] = rest ? glm::min(slo[rest], c.lo) : c.lo;
+                            shi[s] = rest ? glm::max(shi[rest], c.hi) : c.hi;
+                            if (rest == 0)
+                            {
+                                scost[s] = cost[leaves[m]];
+                                continue;
+                            }
+                            float best = 1.e30f;
+                            for (int q = (s - 1) & s; q > 0; q = (q - 1) & s)
+                            {
+                                if (q > (s ^ q)) continue;      //Each partition once
+                                float c2 = scost[q] + scost[s ^ q];
+                                if (c2 < best)
+                                {
+                                    best = c2;
+                                    spart[s] = q;
+                                }
+                            }
+                            scost[s] = NODE_COST * area(slo[s], shi[s]) + best;
+                        }
+
+                        //Rebuild the treelet if the best topology is cheaper
+                        if (scost[subsets - 1] < cost[node])
+                        {
+                            //Pre-order walk of the new topology, reusing the opened nodes
+                            int built[TREELET_SIZE], builtSet[TREELET_SIZE];
+                            int nBuilt = 1, nextInner = 0;
+                            built[0] = node;
+                            builtSet[0] = subsets - 1;
+                            for (int m = 0; m < nBuilt; m++)
+                            {
+                                int s = builtSet[m];
+                                int halves[2] = {spart[s], s ^ spart[s]};
+                                int child[2];
+                                for (int h = 0; h < 2; h++)
+                                {
+                                    if ((halves[h] & (halves[h] - 1)) == 0)
+                                        child[h] = leaves[__builtin_ctz(halves[h])];
+                                    else
+                                    {
+                                        child[h] = inner[nextInner++];
+                                        built[nBuilt] = child[h];
+                                        builtSet[nBuilt++] = halves[h];
+                                    }
+                                    parent[child[h]] = built[m];
+                                }
+                                Node& tn = nodes_[built[m]];
+                                tn.left = child[0];
+                                tn.right = child[1];
+                                tn.lo = slo[s];
+                                tn.hi = shi[s];
+                                cost[built[m]] = scost[s];
+                            }
+                            for (int m = nBuilt - 1; m >= 0; m--)
+                                leafCount[built[m]] = leafCount[nodes_[built[m]].left] + leafCount[nodes_[built[m]].right];
+                        }
+                    }
+                    node = parent[node];
+                }
+            }
+        });
+    }
+}
+
+//---Merges sibling leaves of quadrics into leaves of up to QUADRIC_LANES ----------
+//   One pack tests a whole leaf, so a merged leaf can cost a ray less than the
+//     box tests and the objects of its halves; leaves are merged bottom up when
+//     the SAH says so.  Only leaves whose objects lie side by side in prims_
+//     are merged (treelet restructuring can separate them).
+//----------------------------------------------------------------------------------
+void BVH::widenLeaves(int index, const std::vector<char>& isQuadric)
+{
+    if (nodes_[index].count > 0) return;
+    widenLeaves(nodes_[index].left, isQuadric);
+    widenLeaves(nodes_[index].right, isQuadric);
+
+    Node& node = nodes_[index];
+    const Node& left = nodes_[node.left];
+    const Node& right = nodes_[node.right];
+    int count = left.count + right.count;
+    if (left.count == 0 || right.count == 0 || count > QUADRIC_LANES) return;
+    int first = std::min(left.first, right.first);
+    if (std::max(left.first, right.first) != first + (first == left.first ? left.count : right.count)) return;
+    for (int k = first; k < first + count; k++)
+        if (!isQuadric[prims_[k]]) return;
+
+    float split = NODE_COST * area(node.lo, node.hi) + leafCost(left.count, left.count) * area(left.lo, left.hi) +
+                  leafCost(right.count, right.count) * area(right.lo, right.hi);
+    if (leafCost(count, count) * area(node.lo, node.hi) > split) return;
+    node.first = first;
+    node.count = count;
+}
+
+//---Puts the quadrics of each leaf into packs ---------------------------------------
+//   Quadrics are moved to the front of their leaf, keeping their order, and
+//     copied into QuadricPacks; nothing is done without the AVX2 kernel.
+//     Leaves of fewer quadrics than a pack costs keep calling intersect().
+//----------------------------------------------------------------------------------
+void BVH::packLeaves(std::vector<SceneObject*>& objects)
+{
+    if (!quadricKernelAvailable() || nodes_.empty()) return;
+    std::vector<Quadric> quadrics(objects.size());
+    std::vector<char> isQuadric(objects.size());
+    for (int i = 0; i < (int)objects.size(); i++) isQuadric[i] = objects[i]->quadric(quadrics[i]);
+    widenLeaves(0, isQuadric);
+
+    std::vector<int> stack = {0};
+    while (!stack.empty())
+    {
+        Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        if (node.count == 0)
+        {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+            continue;
+        }
+
+        int* first = &prims_[node.first];
+        int packed = (int)(std::stable_partition(first, first + node.count, [&](int i) { return isQuadric[i] != 0; }) - first);
+        if (PRIM_COST * packed < PACK_COST) continue;
+        node.pack = (int)packs_.size();
+        node.packed = packed;
+        for (int k = 0; k < packed; k += QUADRIC_LANES)
+        {
+            QuadricPack pack;
+            pack.clear();
+            for (int lane = 0; lane < std::min(QUADRIC_LANES, packed - k); lane++) pack.set(lane, quadrics[first[k + lane]]);
+            packs_.push_back(pack);
+        }
+    }
+}
+
+//Works out the statistics of a finished tree
+void BVH::finish()
+{
+    stats_.nodes = 0;
+    stats_.bytes = nodes_.capacity() * sizeof(Node) + prims_.capacity() * sizeof(int) +
+                   packs_.capacity() * sizeof(QuadricPack);
+    stats_.peakBytes = std::max(stats_.peakBytes, stats_.bytes);
+    if (nodes_.empty()) return;
+
+    float rootArea = std::max(area(nodes_[0].lo, nodes_[0].hi), 1.e-12f);
+    std::vector<std::pair<int, int>> stack = {{0, 1}};
+    while (!stack.empty())
+    {
+        int index = stack.back().first, depth = stack.back().second;
+        stack.pop_back();
+        const Node& node = nodes_[index];
+        stats_.nodes++;
+        stats_.maxDepth = std::max(stats_.maxDepth, depth);
+        float a = area(node.lo, node.hi) / rootArea;
+        if (node.count > 0)
+        {
+            stats_.leaves++;
+            stats_.sahCost += leafCost(node.count, node.packed) * a;
+        }
+        else
+        {
+            stats_.sahCost += NODE_COST * a;
+            stack.push_back({node.left, depth + 1});
+            stack.push_back({node.right, depth + 1});
+        }
+    }
+}
+
+void BVH::clear()
+{
+    nodes_.clear();
+    nodes_.shrink_to_fit();
+    prims_.clear();
+    prims_.shrink_to_fit();
+    packs_.clear();
+    packs_.shrink_to_fit();
+    objectCount_ = 0;
+    stats_ = BVHStats();
+}
+
+//True if the tree was built over this many objects
+bool BVH::isCurrent(int objectCount)
+{
+    return !nodes_.empty() && objectCount_ == objectCount;
+}
+
+BVHStats BVH::getStats()
+{
+    return stats_;
+}
+
+//Distance at which a ray enters a box, or a negative value if it misses it
+static inline float entry(const glm::vec3& lo, const glm::vec3& hi, const glm::vec3& p0, const glm::vec3& inv, float tmax)
+{
+    float tnear = 0, tfar = tmax;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float t1 = (lo[axis] - p0[axis]) * inv[axis];
+        float t2 = (hi[axis] - p0[axis]) * inv[axis];
+        float a = (t1 < t2) ? t1 : t2;
+        float b = (t1 < t2) ? t2 : t1;
+        if (a > tnear) tnear = a;           //NaNs (ray in the plane of a face) leave the interval as it is
+        if (b < tfar) tfar = b;
+    }
+    return (tnear <= tfar) ? tnear : -1;
+}
+
+//---Finds the closest point of intersection of a ray with the objects -------------
+//   Same result as Ray::closestPt(): the nearest hit closer than 1.e+6 (or maxDist),
+//   the lowest object index winning a tie.  Returns the number of objects tested.
+//----------------------------------------------------------------------------------
+int BVH::closestPt(Ray& ray, std::vector<SceneObject*>& sceneObjects, float maxDist)
+{
+    float tmin = maxDist;
+    int tests = 0;
+    glm::vec3 inv = 1.0f / ray.dir;
+    int stack[STACK_SIZE];
+    float stackEntry[STACK_SIZE];
+    int sp = 0;
+
+    if (entry(nodes_[0].lo, nodes_[0].hi, ray.p0, inv, tmin) < 0) return 0;
+    stack[sp] = 0;
+    stackEntry[sp++] = 0;
+    while (sp > 0)
+    {
+        sp--;
+        if (stackEntry[sp] > tmin) continue;
+        const Node& node = nodes_[stack[sp]];
+
+        if (node.count > 0)
+        {
+            tests += node.count;
+            auto consider = [&](int i, float t) {
+                if (t > 0 && (t < tmin || (t == tmin && i < ray.index)))
+                {
+                    ray.hit = ray.p0 + ray.dir * t;
+                    ray.index = i;
+                    ray.dist = t;
+                    tmin = t;
+                }
+            };
+            for (int k = 0, p = node.pack; k < node.packed; k += QUADRIC_LANES, p++)
+            {
+                float t[QUADRIC_LANES];
+                intersectQuadrics(packs_[p], ray.p0, ray.dir, t);
+                for (int lane = 0; lane < std::min(QUADRIC_LANES, node.packed - k); lane++)
+                    consider(prims_[node.first + k + lane], t[lane]);
+            }
+            for (int k = node.first + node.packed; k < node.first + node.count; k++)
+                consider(prims_[k], sceneObjects[prims_[k]]->intersect(ray.p0, ray.dir));
+            continue;
+        }
+
+        //Visit the nearer child first
+        float tl = entry(nodes_[node.left].lo, nodes_[node.left].hi, ray.p0, inv, tmin);
+        float tr = entry(nodes_[node.right].lo, nodes_[node.right].hi, ray.p0, inv, tmin);
+        int near = node.left, far = node.right;
+        if (tr >= 0 && (tl < 0 || tr < tl))
+        {
+            std::swap(near, far);
+            std::swap(tl, tr);
+        }
+        if (tr >= 0)
+        {
+            stack[sp] = far;
+            stackEntry[sp++] = tr;
+        }
+        if (tl >= 0)
+        {
+            stack[sp] = near;
+            stackEntry[sp++] = tl;
+        }
+    }
+    return tests;
+}
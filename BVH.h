@@ -0,0 +1,87 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The bounding volume hierarchy class
+*  A binary tree of axis-aligned boxes over the objects of a
+*  scene, so that a ray only tests the objects whose boxes
+*  it passes through.  Two builds are offered:
+*    BVH_SAH   binned surface area heuristic, top down on one
+*              thread; slower to build, faster to trace.
+*    BVH_LBVH  objects sorted by the Morton code of their
+*              centre and split where the codes differ
+*              (Karras 2012), on several threads.  It can be
+*              refined by treelet restructuring (Karras and
+*              Aila 2013).
+*  closestPt() returns exactly what Ray::closestPt() does,
+*  including the choice between hits at the same distance.
+*  Where the processor has AVX2, sibling leaves of spheres,
+*  cylinders and cones are merged up to QUADRIC_LANES
+*  objects, and each leaf's quadrics are tested at once
+*  (see Quadric.h).
+-------------------------------------------------------------*/
+
+#ifndef H_BVH
+#define H_BVH
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "SceneObject.h"
+#include "Ray.h"
+#include "Quadric.h"
+
+enum BVHBuild
+{
+    BVH_SAH,
+    BVH_LBVH
+};
+
+struct BVHStats
+{
+    double buildMs = 0;     //Wall-clock time of the last build
+    size_t bytes = 0;       //Memory kept by the tree
+    size_t peakBytes = 0;   //Memory used during the build, including the tree
+    int nodes = 0;
+    int leaves = 0;
+    int maxDepth = 0;
+    float sahCost = 0;      //Expected cost of a ray, relative to one box test at the root
+};
+
+class BVH
+{
+private:
+    struct Node
+    {
+        glm::vec3 lo, hi;   //Bounding box
+        int left, right;    //Children of an internal node
+        int first, count;   //Leaf: prims_[first .. first+count-1]; count is 0 for internal nodes
+        int pack = 0;       //Leaf: the first 'packed' of its objects are in packs_[pack ...]
+        int packed = 0;
+    };
+
+    struct Prim
+    {
+        glm::vec3 lo, hi, centre;
+        int index;
+    };
+
+    std::vector<Node> nodes_;       //The root is nodes_[0]
+    std::vector<int> prims_;        //Object indices, grouped by leaf
+    std::vector<QuadricPack> packs_;
+    int objectCount_ = 0;
+    BVHStats stats_;
+
+    int buildSAH(std::vector<Prim>& prims, int first, int count);
+    void buildLBVH(std::vector<Prim>& prims, int threads, int treeletPasses);
+    void widenLeaves(int index, const std::vector<char>& isQuadric);
+    void packLeaves(std::vector<SceneObject*>& objects);
+    void finish();
+
+public:
+    void build(std::vector<SceneObject*>& objects, BVHBuild method, int threads = 0, int treeletPasses = 0);
+    void clear();
+    bool isCurrent(int objectCount);
+    int closestPt(Ray& ray, std::vector<SceneObject*>& sceneObjects, float maxDist = 1.e+6);
+    BVHStats getStats();
+};
+
+#endif //!H_BVH
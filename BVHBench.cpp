@@ -0,0 +1,199 @@
+/*==================================================================================
+* COSC 363  Computer Graphics
+* Department of Computer Science and Software Engineering, University of Canterbury.
+*
+* BVH benchmark
+* Fills a box with random spheres, cylinders, cones and triangles, then for each
+* BVH build reports the build time, the memory used, the tree's expected cost
+* and how fast it traces rays.  A sample of the rays is checked against testing
+* every object.  The "kernel" mode instead checks that intersectQuadrics() gives
+* each object's own intersect() to the bit, over random packs of spheres, capped
+* and open cylinders and cones, with rays from outside and inside the objects
+* and vertical rays among them.
+*
+* Usage:  BVHBench.out [objects] [threads] [rays]
+*         BVHBench.out kernel [packs]
+*===================================================================================
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include "Scene.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Cylinder.h"
+#include "Cone.h"
+#include "Quadric.h"
+using namespace std;
+
+const float BOX_SIZE = 1000;    //Side of the cube holding the objects
+const int CHECK_RAYS = 100;     //Rays compared with the brute-force result
+const int KERNEL_RAYS = 16;     //Rays tested against each pack in the kernel check
+
+//Random objects with sizes chosen so that the box is roughly half full
+static void fillScene(Scene& scene, int count)
+{
+    mt19937 rng(363);
+    uniform_real_distribution<float> pos(0, BOX_SIZE);
+    uniform_real_distribution<float> unit(0, 1);
+    float size = BOX_SIZE / cbrt((float)count) * 0.4f;
+
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 c(pos(rng), pos(rng), pos(rng));
+        float r = size * (0.25f + unit(rng));
+        switch (i % 8)
+        {
+        case 0:
+            scene.add(new Cylinder(c, r * 0.5f, r, true));
+            break;
+        case 1:
+            scene.add(new Cone(c, r * 0.5f, r));
+            break;
+        case 2:
+        case 3:
+            scene.add(new Plane(c, c + glm::vec3(r, 0, 0), c + glm::vec3(0, r, r)));
+            break;
+        default:
+            scene.add(new Sphere(c, r * 0.5f));
+        }
+    }
+}
+
+//Rays from a point outside the box towards random points inside it
+static vector<Ray> makeRays(int count)
+{
+    mt19937 rng(42);
+    uniform_real_distribution<float> pos(0, BOX_SIZE);
+    glm::vec3 eye(BOX_SIZE * 0.5f, BOX_SIZE * 0.5f, BOX_SIZE * 2);
+    vector<Ray> rays;
+    for (int i = 0; i < count; i++)
+        rays.push_back(Ray(eye, glm::vec3(pos(rng), pos(rng), pos(rng)) - eye));
+    return rays;
+}
+
+//Compares intersectQuadrics() with each object's intersect(); returns the number of mismatches
+static long checkKernel(int packs)
+{
+    mt19937 rng(363);
+    uniform_real_distribution<float> unit(-1, 1);
+    long tests = 0, hits = 0, errors = 0;
+
+    for (int p = 0; p < packs; p++)
+    {
+        SceneObject* objects[QUADRIC_LANES];
+        QuadricPack pack;
+        pack.clear();
+        for (int lane = 0; lane < QUADRIC_LANES; lane++)
+        {
+            glm::vec3 c(5 * unit(rng), 5 * unit(rng), 5 * unit(rng));
+            float r = 1.5f + 0.5f * unit(rng);
+            float h = 2 + unit(rng);
+            switch ((lane + p) % 4)
+            {
+            case 0: objects[lane] = new Sphere(c, r); break;
+            case 1: objects[lane] = new Cylinder(c, r, h, true); break;
+            case 2: objects[lane] = new Cylinder(c, r, h, false); break;
+            default: objects[lane] = new Cone(c, r, h);
+            }
+            Quadric q;
+            objects[lane]->quadric(q);
+            pack.set(lane, q);
+        }
+
+        for (int i = 0; i < KERNEL_RAYS; i++)
+        {
+            //Aimed at a random object, from outside them all or from inside that one
+            Quadric q;
+            objects[rng() % QUADRIC_LANES]->quadric(q);
+            glm::vec3 target = q.centre + glm::vec3(q.radius * unit(rng), (q.shape == QUADRIC_SPHERE) ? q.radius * unit(rng) : q.height * (0.5f + 0.6f * unit(rng)), q.radius * unit(rng));
+            glm::vec3 p0 = (i % 2 == 0) ? glm::vec3(20 * unit(rng), 20 * unit(rng), 20 * unit(rng))
+                                        : q.centre + glm::vec3(0.5f * q.radius * unit(rng), (q.shape == QUADRIC_SPHERE) ? 0.5f * q.radius * unit(rng) : q.height * (0.5f + 0.4f * unit(rng)), 0.5f * q.radius * unit(rng));
+            glm::vec3 dir = (i % 4 == 1) ? glm::vec3(0, (i % 8 == 1) ? 1 : -1, 0)    //Vertical: a == 0 for cylinders
+                                         : glm::normalize(target - p0);
+            if (i % 4 == 3) dir = glm::vec3(0, (p0.y < target.y) ? 1 : -1, 0);
+            float t[QUADRIC_LANES];
+            intersectQuadrics(pack, p0, dir, t);
+            for (int lane = 0; lane < QUADRIC_LANES; lane++)
+            {
+                float expected = objects[lane]->intersect(p0, dir);
+                tests++;
+                if (expected > 0) hits++;
+                if (memcmp(&expected, &t[lane], sizeof(float)) != 0) errors++;
+            }
+        }
+        for (SceneObject* obj : objects) delete obj;
+    }
+    cout << tests << " tests, " << hits << " hits, " << errors << " mismatches" << endl;
+    return errors;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "kernel") == 0)
+    {
+        if (!quadricKernelAvailable())
+        {
+            cout << "*** Error: the quadric kernel needs AVX2" << endl;
+            return 1;
+        }
+        return (checkKernel((argc > 2) ? atoi(argv[2]) : 100000) == 0) ? 0 : 1;
+    }
+
+    int count = (argc > 1) ? atoi(argv[1]) : 100000;
+    int threads = (argc > 2) ? atoi(argv[2]) : 0;
+    int rayCount = (argc > 3) ? atoi(argv[3]) : 200000;
+
+    Scene scene;
+    fillScene(scene, count);
+    vector<Ray> rays = makeRays(rayCount);
+
+    //Reference hits for a sample of the rays
+    vector<Ray> reference(rays.begin(), rays.begin() + min(CHECK_RAYS, rayCount));
+    auto start = chrono::steady_clock::now();
+    for (Ray& ray : reference) ray.closestPt(scene.objects);
+    double linearSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    struct Config { const char* name; BVHBuild method; int passes; };
+    Config configs[] = {
+        {"SAH", BVH_SAH, 0},
+        {"LBVH", BVH_LBVH, 0},
+        {"LBVH+treelets", BVH_LBVH, 3},
+    };
+
+    cout << count << " objects, " << rayCount << " rays" << endl;
+    cout << left << setw(16) << "build" << right << setw(10) << "ms" << setw(10) << "MB" << setw(10) << "peak MB"
+         << setw(8) << "depth" << setw(10) << "SAH cost" << setw(10) << "Mrays/s" << setw(10) << "errors" << endl;
+    cout << left << setw(16) << "none" << right << setw(58) << fixed << setprecision(4)
+         << reference.size() / linearSeconds / 1.e6 << endl;
+    for (Config& config : configs)
+    {
+        scene.buildBVH(config.method, threads, config.passes);
+        BVHStats stats = scene.getBVHStats();
+
+        start = chrono::steady_clock::now();
+        for (Ray ray : rays) scene.closestPt(ray);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        int errors = 0;
+        for (int i = 0; i < (int)reference.size(); i++)
+        {
+            Ray ray = rays[i];
+            scene.closestPt(ray);
+            if (ray.index != reference[i].index || ray.dist != reference[i].dist) errors++;
+        }
+
+        cout << left << setw(16) << config.name << right << fixed
+             << setw(10) << setprecision(1) << stats.buildMs
+             << setw(10) << setprecision(1) << stats.bytes / 1048576.0
+             << setw(10) << setprecision(1) << stats.peakBytes / 1048576.0
+             << setw(8) << stats.maxDepth
+             << setw(10) << setprecision(1) << stats.sahCost
+             << setw(10) << setprecision(2) << rayCount / seconds / 1.e6
+             << setw(10) << errors << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The camera class
+-------------------------------------------------------------*/
+
+#include "Camera.h"
+#include <math.h>
+
+const float MAX_PITCH = 89;
+
+//Unit viewing direction
+glm::vec3 Camera::forward()
+{
+    float y = glm::radians(yaw);
+    float p = glm::radians(pitch);
+    return glm::vec3(-sin(y)*cos(p), sin(p), -cos(y)*cos(p));
+}
+
+//Unit vector pointing to the right of the image plane
+glm::vec3 Camera::right()
+{
+    float y = glm::radians(yaw);
+    return glm::vec3(cos(y), 0, -sin(y));
+}
+
+//Unit vector pointing up the image plane
+glm::vec3 Camera::up()
+{
+    return glm::cross(right(), forward());
+}
+
+/**
+* Direction of the primary ray through the point (x, y) of an image
+* plane at distance 'edist' in front of the eye.
+*/
+glm::vec3 Camera::rayDir(float x, float y, float edist)
+{
+    return x * right() + y * up() + edist * forward();
+}
+
+/**
+* Moves the eye along the viewing direction, the image plane's right
+* vector and the world up vector.
+*/
+void Camera::move(float dForward, float dRight, float dUp)
+{
+    eye += dForward * forward() + dRight * right() + glm::vec3(0, dUp, 0);
+}
+
+void Camera::turn(float dYaw, float dPitch)
+{
+    yaw = fmod(yaw + dYaw, 360.0f);
+    pitch += dPitch;
+    if (pitch > MAX_PITCH) pitch = MAX_PITCH;
+    if (pitch < -MAX_PITCH) pitch = -MAX_PITCH;
+}
@@ -0,0 +1,35 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The camera class
+*  A pinhole camera at 'eye', turned by 'yaw' about the
+*  y-axis and tilted by 'pitch'.  With both angles zero it
+*  looks down the -z axis, as the original fixed view did.
+-------------------------------------------------------------*/
+
+#ifndef H_CAMERA
+#define H_CAMERA
+#include <glm/glm.hpp>
+
+class Camera
+{
+public:
+    glm::vec3 eye = glm::vec3(0);   //Centre of projection
+    float yaw = 0;                  //Rotation about the y-axis, in degrees (positive turns left)
+    float pitch = 0;                //Rotation above the horizon, in degrees
+
+    Camera() {}
+
+    Camera(glm::vec3 e, float y, float p) : eye(e), yaw(y), pitch(p) {}
+
+    glm::vec3 forward();
+    glm::vec3 right();
+    glm::vec3 up();
+
+    glm::vec3 rayDir(float x, float y, float edist);
+
+    void move(float dForward, float dRight, float dUp);
+    void turn(float dYaw, float dPitch);
+};
+
+#endif //!H_CAMERA
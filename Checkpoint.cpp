@@ -0,0 +1,186 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The checkpoint class
+-------------------------------------------------------------*/
+
+#include "Checkpoint.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+const char MAGIC[8] = {'R', 'T', 'C', 'K', 'P', 'T', '0', '1'};
+
+struct CheckpointHeader
+{
+    char magic[8];
+    uint64_t sceneHash;
+    uint64_t settingsHash;
+    int32_t tileCount;
+    int32_t unused;
+};
+
+//A tile record is its index, its pixels (3 floats each, row by row) and a checksum of both
+static size_t recordSize(Tile& tile)
+{
+    return sizeof(int32_t) + 3 * sizeof(float) * (tile.x1 - tile.x0) * (tile.y1 - tile.y0) + sizeof(uint64_t);
+}
+
+static double seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Fingerprint::add(const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t k = 0; k < size; k++)
+    {
+        hash_ ^= bytes[k];
+        hash_ *= 1099511628211ull;
+    }
+}
+
+Checkpoint::~Checkpoint()
+{
+    close();
+}
+
+//---Opens a checkpoint, resuming it if it matches ----------------------------------
+//   If the file holds a checkpoint of the same scene, settings and tiles, each
+//     complete tile record in it is passed to 'restored' and later records are
+//     appended after them.  Otherwise the file is started afresh.  Records are
+//     appended every intervalSeconds (0 for every tile) and on close().
+//----------------------------------------------------------------------------------
+bool Checkpoint::open(const char* filename, uint64_t sceneHash, uint64_t settingsHash, std::vector<Tile>& tiles,
+                      double intervalSeconds, std::function<void(int tile, Image& pixels)> restored)
+{
+    close();
+    failed_ = false;
+    tiles_ = tiles;
+    interval_ = intervalSeconds;
+    lastFlush_ = seconds();
+
+    fd_ = ::open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+    {
+        std::cout << "*** Error opening checkpoint file: " << filename << std::endl;
+        return false;
+    }
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.sceneHash = sceneHash;
+    header.settingsHash = settingsHash;
+    header.tileCount = (int32_t)tiles.size();
+
+    CheckpointHeader found;
+    off_t end = 0;
+    int count = 0;
+    if (pread(fd_, &found, sizeof(found), 0) == sizeof(found) && memcmp(&found, &header, sizeof(header)) == 0)
+    {
+        end = sizeof(header);
+        std::vector<char> done(tiles.size(), 0);
+        std::vector<unsigned char> bytes;
+        int32_t t;
+        while (pread(fd_, &t, sizeof(t), end) == sizeof(t) && t >= 0 && t < (int)tiles.size() && !done[t])
+        {
+            Tile& tile = tiles[t];
+            bytes.resize(recordSize(tile));
+            if (pread(fd_, bytes.data(), bytes.size(), end) != (ssize_t)bytes.size()) break;
+            Fingerprint checksum;
+            checksum.add(bytes.data(), bytes.size() - sizeof(uint64_t));
+            uint64_t stored;
+            memcpy(&stored, bytes.data() + bytes.size() - sizeof(uint64_t), sizeof(stored));
+            if (stored != checksum.value()) break;
+
+            Image pixels(tile.x1 - tile.x0, tile.y1 - tile.y0, tile.x0, tile.y0);
+            const unsigned char* p = bytes.data() + sizeof(int32_t);
+            for (int j = tile.y0; j < tile.y1; j++)
+                for (int i = tile.x0; i < tile.x1; i++, p += 3 * sizeof(float))
+                    memcpy(&pixels.at(i, j), p, 3 * sizeof(float));
+            restored(t, pixels);
+            done[t] = 1;
+            count++;
+            end += bytes.size();
+        }
+        std::cout << "Resuming " << count << " of " << tiles.size() << " tiles from checkpoint " << filename << std::endl;
+    }
+    else if (pread(fd_, &found, 1, 0) == 1)
+        std::cout << "Checkpoint " << filename << " is of another scene or settings; starting afresh" << std::endl;
+
+    //Drop whatever follows the last good record, such as one cut short by a crash
+    if (ftruncate(fd_, end) != 0 || lseek(fd_, end, SEEK_SET) != end ||
+        (end == 0 && ::write(fd_, &header, sizeof(header)) != sizeof(header)))
+    {
+        std::cout << "*** Error writing checkpoint file: " << filename << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+//Appends the records collected so far and waits for them to reach the disk
+bool Checkpoint::flush()
+{
+    size_t done = 0;
+    while (done < pending_.size() && !failed_)
+    {
+        ssize_t n = ::write(fd_, pending_.data() + done, pending_.size() - done);
+        if (n <= 0) failed_ = true;
+        else done += n;
+    }
+    if (!failed_ && !pending_.empty() && fdatasync(fd_) != 0) failed_ = true;
+    if (failed_) std::cout << "*** Error writing checkpoint" << std::endl;
+    pending_.clear();
+    lastFlush_ = seconds();
+    return !failed_;
+}
+
+/**
+* Records a finished tile.  May be called from several threads at once; the
+* thread that finds the interval has passed appends everything collected.
+*/
+void Checkpoint::record(int tile, Image& pixels)
+{
+    if (fd_ < 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_) return;
+
+    Tile& t = tiles_[tile];
+    size_t start = pending_.size();
+    pending_.resize(start + recordSize(t));
+    unsigned char* p = pending_.data() + start;
+    int32_t index = tile;
+    memcpy(p, &index, sizeof(index));
+    p += sizeof(index);
+    for (int j = t.y0; j < t.y1; j++)
+        for (int i = t.x0; i < t.x1; i++, p += 3 * sizeof(float))
+            memcpy(p, &pixels.at(i, j), 3 * sizeof(float));
+    Fingerprint checksum;
+    checksum.add(pending_.data() + start, p - (pending_.data() + start));
+    uint64_t value = checksum.value();
+    memcpy(p, &value, sizeof(value));
+
+    if (seconds() - lastFlush_ >= interval_) flush();
+}
+
+/**
+* Appends any records still held and closes the file.  Returns false if
+* anything failed.
+*/
+bool Checkpoint::close()
+{
+    if (fd_ < 0) return !failed_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!failed_) flush();
+    }
+    if (::close(fd_) != 0) failed_ = true;
+    fd_ = -1;
+    return !failed_;
+}
@@ -0,0 +1,66 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The checkpoint class
+*  Saves the finished tiles of a render to a file, so that
+*  a render that is killed can be resumed where it left
+*  off.  The file starts with fingerprints of the scene and
+*  of the settings that affect pixels, followed by one
+*  record per tile in the order they finished.  Records
+*  are collected in memory and appended at most once per
+*  interval; a record cut short by a crash is ignored.  A
+*  checkpoint is only resumed if both fingerprints match.
+-------------------------------------------------------------*/
+
+#ifndef H_CHECKPOINT
+#define H_CHECKPOINT
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "TileSink.h"
+
+/**
+ * FNV-1a hash of a sequence of values, for telling scenes and settings apart.
+ */
+class Fingerprint
+{
+private:
+    uint64_t hash_ = 14695981039346656037ull;
+
+public:
+    void add(const void* data, size_t size);
+
+    template <class T> void add(const T& value) { add(&value, sizeof(value)); }
+
+    uint64_t value() { return hash_; }
+};
+
+class Checkpoint
+{
+private:
+    int fd_ = -1;
+    std::vector<Tile> tiles_;
+    std::vector<unsigned char> pending_;    //Records not appended yet
+    double interval_ = 0;
+    double lastFlush_ = 0;
+    std::mutex mutex_;
+    bool failed_ = false;
+
+    bool flush();
+
+public:
+    Checkpoint() = default;
+    ~Checkpoint();
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    bool open(const char* filename, uint64_t sceneHash, uint64_t settingsHash, std::vector<Tile>& tiles,
+              double intervalSeconds, std::function<void(int tile, Image& pixels)> restored);
+    void record(int tile, Image& pixels);
+    bool close();
+};
+
+#endif //!H_CHECKPOINT
@@ -3,7 +3,9 @@
 //
 
 #include "Cone.h"
+#include "Quadric.h"
 #include <math.h>
+#include <algorithm>
 
 /**
 * Cone intersection method. The input is a ray.
@@ -43,6 +45,10 @@ float Cone::intersect(glm::vec3 p0, glm::vec3 dir)
 
 
     glm::vec3 point = p0 + closestVal*dir;
+    if (point.y < center.y)     //Below the base
+    {
+        return -1;
+    }
     if (point.y > trueHeight)
     {
         return -1;
@@ -62,3 +68,85 @@ glm::vec3 Cone::normal(glm::vec3 p)
     glm::vec3 n(sin(alpha)*cos(theta), sin(theta), cos(alpha)*cos(theta));
     return n;
 }
+
+/**
+ * Span of the ray inside the solid cone, between the plane of its base and its
+ * apex.  The quadratic of intersect() is negative inside both nappes of the
+ * double cone, so of its one or two spans the one between the base and the
+ * apex is taken.  Returns false if the ray leaves through the plane of the
+ * base or of the apex, as the cone has no base and intersect() no surface
+ * there.
+ */
+bool Cone::interval(glm::vec3 p0, glm::vec3 dir, float& tEntry, float& tExit)
+{
+    float xDif = p0.x - center.x;
+    float zDif = p0.z - center.z;
+    float yDif = height - p0.y + center.y;
+    float heightConstant = (radius/height) * (radius/height);
+
+    float a = dir.x*dir.x + dir.z*dir.z - heightConstant*dir.y*dir.y;
+    float b = 2*(dir.x*xDif + dir.z*zDif + heightConstant*dir.y*yDif);
+    float c = xDif*xDif + zDif*zDif - heightConstant*yDif*yDif;
+    float delta = b*b - 4.0f*a*c;
+
+    //Span between the planes of the base and the apex
+    float lo = -1.e+6, hi = 1.e+6;
+    float tBase = 0, tApex = 0;
+    if (dir.y != 0)
+    {
+        tBase = (center.y-p0.y)/dir.y;
+        tApex = (center.y+height-p0.y)/dir.y;
+        lo = fmin(tBase, tApex);
+        hi = fmax(tBase, tApex);
+    }
+    else if (p0.y < center.y || p0.y > center.y + height) return false;
+
+    if (fabs(a) < 1.e-12f) return false;       //Ray parallel to the side: grazes at most
+    if (delta < 0.001) return false;            //Outside the double cone throughout, or inside it up to a plane
+
+    float t1 = (-b - sqrt(delta))/(2.0f*a);
+    float t2 = (-b + sqrt(delta))/(2.0f*a);
+    if (t1 > t2) std::swap(t1, t2);
+
+    if (a > 0)          //Inside between the roots
+    {
+        tEntry = fmax(lo, t1);
+        tExit = fmin(hi, t2);
+    }
+    else if (t1 > lo)   //Inside before the first root or after the second
+    {
+        tEntry = lo;
+        tExit = fmin(hi, t1);
+    }
+    else
+    {
+        tEntry = fmax(lo, t2);
+        tExit = hi;
+    }
+    if (dir.y != 0 && (tExit == tBase || tExit == tApex)) return false;
+    return tEntry < tExit;
+}
+
+/**
+ * Returns the bounding box of the cone, from its base to its apex.
+ */
+void Cone::bounds(glm::vec3& lo, glm::vec3& hi)
+{
+    lo = glm::vec3(center.x - radius, center.y, center.z - radius);
+    hi = glm::vec3(center.x + radius, center.y + height, center.z + radius);
+}
+
+SceneObject* Cone::clone()
+{
+    return new Cone(*this);
+}
+
+bool Cone::quadric(Quadric& q)
+{
+    q.shape = QUADRIC_CONE;
+    q.centre = center;
+    q.radius = radius;
+    q.height = height;
+    q.cap = false;
+    return true;
+}
@@ -32,5 +32,13 @@ public:
     float intersect(glm::vec3 p0, glm::vec3 dir);
 
     glm::vec3 normal(glm::vec3 p);
+
+    void bounds(glm::vec3& lo, glm::vec3& hi);
+
+    bool interval(glm::vec3 p0, glm::vec3 dir, float& tEntry, float& tExit);
+
+    SceneObject* clone();
+
+    bool quadric(Quadric& q);
 };
 #endif //!H_CONE
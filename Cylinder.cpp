@@ -3,6 +3,7 @@
 //
 
 #include "Cylinder.h"
+#include "Quadric.h"
 #include <math.h>
 
 /**
@@ -42,6 +43,14 @@
 
     glm::vec3 point = p0 + closeValue*dir;
 
+    // The cylinder stands on its base: ignore the wall below center.y
+    if (point.y < center.y)
+    {
+        point = p0 + farValue*dir;
+        if (farValue > 0 && point.y >= center.y && point.y <= height + center.y) return farValue;
+        return -1;
+    }
+
     if (point.y > height + center.y)
     {
         point = p0 + farValue*dir;
@@ -75,4 +84,71 @@
      glm::vec3 n((p.x-center.x),0,(p.z-center.z));
      n = glm::normalize(n);
      return n;
- }
\ No newline at end of file
+ }
+
+
+/**
+ * Span of the ray inside the solid cylinder, between the planes of its base
+ * and its top.  A ray up the axis direction has a wall interval of any length.
+ * Returns false if the ray leaves through the open base, or through the top
+ * without a cap, as intersect() has no surface there.
+ */
+bool Cylinder::interval(glm::vec3 p0, glm::vec3 dir, float& tEntry, float& tExit)
+{
+    float xDif = p0.x - center.x;
+    float zDif = p0.z - center.z;
+
+    float a = dir.x*dir.x + dir.z*dir.z;
+    float b = 2*(dir.x*xDif+dir.z*zDif);
+    float c = xDif*xDif + zDif*zDif - radius*radius;
+
+    if (a < 1.e-12f)
+    {
+        if (c > 0) return false;
+        tEntry = -1.e+6;
+        tExit = 1.e+6;
+    }
+    else
+    {
+        float delta = b*b - 4.0f*a*c;
+        if(delta < 0.001) return false;
+        tEntry = (-b - sqrt(delta))/(2.0f*a);
+        tExit = (-b + sqrt(delta))/(2.0f*a);
+    }
+
+    if (dir.y != 0)
+    {
+        float tBase = (center.y-p0.y)/dir.y;
+        float tTop = (center.y+height-p0.y)/dir.y;
+        tEntry = fmax(tEntry, fmin(tBase, tTop));
+        tExit = fmin(tExit, fmax(tBase, tTop));
+        if (tExit == tBase || (tExit == tTop && !hasCap)) return false;
+    }
+    else if (p0.y < center.y || p0.y > center.y + height) return false;
+
+    return tEntry < tExit;
+}
+
+/**
+ * Returns the bounding box of the cylinder, from its base to its top.
+ */
+void Cylinder::bounds(glm::vec3& lo, glm::vec3& hi)
+{
+    lo = glm::vec3(center.x - radius, center.y, center.z - radius);
+    hi = glm::vec3(center.x + radius, center.y + height, center.z + radius);
+}
+
+SceneObject* Cylinder::clone()
+{
+    return new Cylinder(*this);
+}
+
+bool Cylinder::quadric(Quadric& q)
+{
+    q.shape = QUADRIC_CYLINDER;
+    q.centre = center;
+    q.radius = radius;
+    q.height = height;
+    q.cap = hasCap;
+    return true;
+}
@@ -0,0 +1,98 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The dependencies class
+-------------------------------------------------------------*/
+
+#include "Dependencies.h"
+#include <algorithm>
+
+/**
+* Empties the record, sized for a render of 'tiles' tiles of a scene of
+* 'objects' objects.  key tells the renders of different views and settings
+* apart.
+*/
+void Dependencies::reset(int tiles, int objects, uint64_t key)
+{
+    key_ = key;
+    tiles_ = tiles;
+    objects_ = objects;
+    words_ = (objects + 63) / 64;
+    bits_.assign((size_t)tiles * words_, 0);
+    bounds_.clear();
+}
+
+//Whether the record is of a render of this many tiles and objects, with this key
+int Dependencies::matches(int tiles, int objects, uint64_t key)
+{
+    return tiles == tiles_ && objects == objects_ && key == key_;
+}
+
+//Bits of tile t, written by the thread rendering it
+uint64_t* Dependencies::tile(int t)
+{
+    return bits_.data() + (size_t)t * words_;
+}
+
+void Dependencies::clear(int t)
+{
+    std::fill(tile(t), tile(t) + words_, 0);
+}
+
+//Makes tile t depend on every object, as when its ray trees are unknown
+void Dependencies::setAll(int t)
+{
+    std::fill(tile(t), tile(t) + words_, ~0ull);
+}
+
+int Dependencies::dependsOn(int t, int object)
+{
+    return (tile(t)[object >> 6] >> (object & 63)) & 1;
+}
+
+//Tiles depending on any of the given objects, in order
+std::vector<int> Dependencies::affected(const std::vector<int>& objects)
+{
+    std::vector<uint64_t> mask(words_, 0);
+    for (int k : objects)
+        if (k >= 0 && k < objects_) set(mask.data(), k);
+
+    std::vector<int> result;
+    for (int t = 0; t < tiles_; t++)
+    {
+        uint64_t* bits = tile(t);
+        for (int w = 0; w < words_; w++)
+            if (bits[w] & mask[w])
+            {
+                result.push_back(t);
+                break;
+            }
+    }
+    return result;
+}
+
+//Records the bounds of the objects being rendered
+void Dependencies::recordBounds(std::vector<SceneObject*>& objects)
+{
+    bounds_.resize(2 * objects.size());
+    for (size_t k = 0; k < objects.size(); k++) objects[k]->bounds(bounds_[2 * k], bounds_[2 * k + 1]);
+}
+
+//Whether any of the changed objects' bounds differ from those recorded, or were not recorded
+int Dependencies::moved(std::vector<SceneObject*>& objects, const std::vector<int>& changed)
+{
+    for (int k : changed)
+    {
+        if (k < 0 || k >= (int)objects.size()) continue;
+        if (2 * k + 1 >= (int)bounds_.size()) return true;
+        glm::vec3 lo, hi;
+        objects[k]->bounds(lo, hi);
+        if (lo != bounds_[2 * k] || hi != bounds_[2 * k + 1]) return true;
+    }
+    return false;
+}
+
+size_t Dependencies::memoryBytes()
+{
+    return bits_.size() * sizeof(uint64_t) + bounds_.size() * sizeof(glm::vec3);
+}
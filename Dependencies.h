@@ -0,0 +1,56 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The dependencies class
+*  Records, for each tile of a render, the objects that the
+*  ray trees of its cells hit: primary hits, shadow ray
+*  occluders and the hits of reflected, refracted and
+*  transmitted rays.  Each tile holds one bit per object.
+*  After an object is edited, only the tiles depending on
+*  it need to be rendered again (see rerender()).
+*
+*  A tile depends on the objects its rays did hit, so a
+*  change to an object's colour, material or coefficients
+*  is caught exactly.  An object moved to where no ray of a
+*  tile met it before, such as into a shadow ray's path or
+*  onto the screen, is not, so the bounds of every object
+*  are recorded too, and rerender() renders the whole image
+*  again once an edited object's bounds have changed.
+-------------------------------------------------------------*/
+
+#ifndef H_DEPENDENCIES
+#define H_DEPENDENCIES
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "SceneObject.h"
+
+class Dependencies
+{
+private:
+    int tiles_ = 0;
+    int objects_ = 0;
+    int words_ = 0;                 //64-bit words per tile
+    uint64_t key_ = 0;              //Fingerprint of the view and settings recorded
+    std::vector<uint64_t> bits_;    //Bit k of tile t: word t*words_ + k/64
+    std::vector<glm::vec3> bounds_; //Low and high corners of each object's box when rendered
+
+public:
+    void reset(int tiles, int objects, uint64_t key);
+    int matches(int tiles, int objects, uint64_t key);
+
+    uint64_t* tile(int t);
+    void clear(int t);
+    void setAll(int t);
+    int dependsOn(int t, int object);
+    std::vector<int> affected(const std::vector<int>& objects);
+    void recordBounds(std::vector<SceneObject*>& objects);
+    int moved(std::vector<SceneObject*>& objects, const std::vector<int>& changed);
+    size_t memoryBytes();
+
+    //Marks object k in a tile's bits
+    static void set(uint64_t* bits, int k) { bits[k >> 6] |= 1ull << (k & 63); }
+};
+
+#endif //!H_DEPENDENCIES
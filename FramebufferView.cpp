@@ -0,0 +1,97 @@
+/*==================================================================================
+* COSC 363  Computer Graphics
+* Department of Computer Science and Software Engineering, University of Canterbury.
+*
+* Shared framebuffer viewer
+* Maps a framebuffer written by a render (see SharedFramebuffer.h), with no
+* copies of its own beyond the snapshot, and reports the progress of the frame
+* in it every interval until the frame is complete.  With a file name, the
+* finished tiles of the last report are written to it as a PPM image, unfinished
+* ones black.  An example of the reading protocol for other viewers.
+*
+* Usage:  FramebufferView.out <name> [snapshot.ppm] [interval ms]
+*===================================================================================
+*/
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "SharedFramebuffer.h"
+#include "Image.h"
+using namespace std;
+
+//Copies the finished tiles of the current frame into image; returns the number copied, or -1 if the frame changed
+static int snapshot(FramebufferHeader* header, const unsigned char* pixels, Image& image)
+{
+    uint64_t frame = header->frame.load(memory_order_acquire);
+    if (frame % 2 != 0) return -1;
+
+    int size = header->tileSize, copied = 0;
+    for (int t = 0; t < header->tilesX * header->tilesY; t++)
+    {
+        if (!(header->bitmap[t / 32].load(memory_order_acquire) & (1u << (t % 32)))) continue;
+        int x0 = (t % header->tilesX) * size, y0 = (t / header->tilesX) * size;
+        for (int j = y0; j < min(y0 + size, header->height); j++)
+            for (int i = x0; i < min(x0 + size, header->width); i++)
+            {
+                long k = (long)j * header->width + i;
+                if (header->format == FB_RGB32F) memcpy(&image.at(i, j), pixels + 12 * k, 12);
+                else image.at(i, j) = glm::vec3(pixels[3 * k], pixels[3 * k + 1], pixels[3 * k + 2]) * (1.0f / 255);
+            }
+        copied++;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return (header->frame.load(memory_order_relaxed) == frame) ? copied : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        cout << "Usage: " << argv[0] << " <name> [snapshot.ppm] [interval ms]" << endl;
+        return 1;
+    }
+    int interval = (argc > 3) ? atoi(argv[3]) : 200;
+
+    int fd = shm_open(argv[1], O_RDONLY, 0);
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (fd >= 0 && fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(FramebufferHeader))
+        memory = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        cout << "*** Cannot map shared framebuffer " << argv[1] << endl;
+        return 1;
+    }
+    FramebufferHeader* header = (FramebufferHeader*)memory;
+    if (memcmp(header->magic, FRAMEBUFFER_MAGIC, sizeof(FRAMEBUFFER_MAGIC)) != 0 ||
+        (size_t)info.st_size < header->headerBytes + 3L * header->width * header->height *
+                                   (header->format == FB_RGB32F ? sizeof(float) : 1))
+    {
+        cout << "*** Not a complete framebuffer: " << argv[1] << endl;
+        return 1;
+    }
+    const unsigned char* pixels = (const unsigned char*)memory + header->headerBytes;
+    int total = header->tilesX * header->tilesY;
+    cout << argv[1] << ": " << header->width << "x" << header->height << ", " << total << " tiles" << endl;
+
+    Image image;
+    int copied;
+    do
+    {
+        image = Image(header->width, header->height);
+        copied = snapshot(header, pixels, image);
+        if (copied < 0) cout << "frame changing" << endl;
+        else cout << "frame " << header->frame.load() / 2 << ": " << copied << "/" << total << " tiles" << endl;
+        if (copied < total) this_thread::sleep_for(chrono::milliseconds(interval));
+    } while (copied < total);
+
+    if (argc > 2 && !image.writePPM(argv[2])) return 1;
+    return 0;
+}
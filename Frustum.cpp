@@ -0,0 +1,94 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The tile frustum class
+-------------------------------------------------------------*/
+
+#include "Frustum.h"
+#include <algorithm>
+
+const float BOX_PAD = 1.e-4f;       //Relative padding of boxes, so rounding never loses a hit
+const float EYE_MARGIN = 0.02f;     //Farthest a primary ray starts from the eye (its step), with margin
+
+//---Finds the objects in the frustum of the image plane's rectangle [x0, x1] x [y0, y1] ---
+//   Boxes are culled only if they lie more than EYE_MARGIN outside a side, as
+//     rays start a step away from the eye.  With 'within', only the objects in
+//     that frustum are considered; it must hold this one.
+//----------------------------------------------------------------------------------
+void TileFrustum::build(std::vector<SceneObject*>& objects, Camera camera, float edist,
+                        float x0, float y0, float x1, float y1, const TileFrustum* within)
+{
+    objects_ = &objects;
+    eye_ = camera.eye;
+    glm::vec3 corner[4] = {camera.rayDir(x0, y0, edist), camera.rayDir(x1, y0, edist),
+                           camera.rayDir(x1, y1, edist), camera.rayDir(x0, y1, edist)};
+    glm::vec3 centre = camera.rayDir(0.5f * (x0 + x1), 0.5f * (y0 + y1), edist);
+    for (int s = 0; s < 4; s++)
+    {
+        planes_[s] = glm::normalize(glm::cross(corner[s], corner[(s + 1) % 4]));
+        if (glm::dot(planes_[s], centre) < 0) planes_[s] = -planes_[s];
+    }
+
+    auto inside = [&](glm::vec3 lo, glm::vec3 hi)
+    {
+        for (int s = 0; s < 4; s++)
+        {
+            glm::vec3 n = planes_[s];
+            glm::vec3 far(n.x > 0 ? hi.x : lo.x, n.y > 0 ? hi.y : lo.y, n.z > 0 ? hi.z : lo.z);
+            if (glm::dot(n, far - eye_) < -EYE_MARGIN) return false;
+        }
+        return true;
+    };
+
+    candidates_.clear();
+    if (within != nullptr)
+    {
+        for (const Candidate& c : within->candidates_)
+            if (inside(c.lo, c.hi)) candidates_.push_back(c);
+        return;                                     //Already nearest first
+    }
+    for (int k = 0; k < (int)objects.size(); k++)
+    {
+        Candidate c;
+        objects[k]->bounds(c.lo, c.hi);
+        glm::vec3 pad = BOX_PAD * (glm::max(glm::abs(c.lo), glm::abs(c.hi)) + glm::vec3(1));
+        c.lo -= pad;
+        c.hi += pad;
+        if (!inside(c.lo, c.hi)) continue;
+        glm::vec3 closest = glm::clamp(eye_, c.lo, c.hi);
+        c.near = glm::length(closest - eye_) * (1 - 1.e-4f) - EYE_MARGIN;
+        c.index = k;
+        candidates_.push_back(c);
+    }
+    std::sort(candidates_.begin(), candidates_.end(),
+              [](const Candidate& a, const Candidate& b) { return a.near < b.near; });
+}
+
+//---As Scene::closestPt() for a primary ray in the frustum ---------------------------
+//   Returns the number of objects tested, or -1 if the ray is not a primary ray
+//     of this frustum, when nothing is done.
+//----------------------------------------------------------------------------------
+int TileFrustum::closestPt(Ray& ray, float maxDist)
+{
+    if (objects_ == nullptr || glm::length(ray.p0 - eye_) > 0.5f * EYE_MARGIN) return -1;
+    for (int s = 0; s < 4; s++)
+        if (glm::dot(planes_[s], ray.dir) < 0) return -1;
+
+    std::vector<SceneObject*>& objects = *objects_;
+    float tmin = maxDist;
+    int tests = 0;
+    for (size_t e = 0; e < candidates_.size() && candidates_[e].near <= tmin; e++)
+    {
+        int k = candidates_[e].index;
+        tests++;
+        float t = objects[k]->intersect(ray.p0, ray.dir);
+        if (t > 0 && (t < tmin || (t == tmin && k < ray.index)))
+        {
+            ray.hit = ray.p0 + ray.dir * t;
+            ray.index = k;
+            ray.dist = t;
+            tmin = t;
+        }
+    }
+    return tests;
+}
@@ -0,0 +1,46 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The tile frustum class
+*  The objects a tile's primary rays can meet.  All those
+*  rays leave the eye through the tile's part of the image
+*  plane, so they stay inside the four planes through the
+*  eye and the part's edges.  An object whose bounding box
+*  lies wholly outside one of the planes is culled, and the
+*  tile's rays are compared with the rest only, nearest
+*  first, stopping once the others lie behind the hit.
+*  Rays outside the frustum are left to the scene, so
+*  results are exactly those of Scene::closestPt().
+-------------------------------------------------------------*/
+
+#ifndef H_FRUSTUM
+#define H_FRUSTUM
+#include <glm/glm.hpp>
+#include <vector>
+#include "SceneObject.h"
+#include "Camera.h"
+#include "Ray.h"
+
+class TileFrustum
+{
+private:
+    struct Candidate
+    {
+        glm::vec3 lo, hi;   //Bounding box, padded
+        float near;         //Lower bound of the distance along any primary ray to a hit
+        int index;
+    };
+
+    std::vector<SceneObject*>* objects_ = nullptr;
+    glm::vec3 eye_;
+    glm::vec3 planes_[4];               //Unit normals of the sides, pointing in
+    std::vector<Candidate> candidates_; //Nearest first
+
+public:
+    void build(std::vector<SceneObject*>& objects, Camera camera, float edist,
+               float x0, float y0, float x1, float y1, const TileFrustum* within = nullptr);
+    int size() { return (int)candidates_.size(); }
+    int closestPt(Ray& ray, float maxDist);
+};
+
+#endif //!H_FRUSTUM
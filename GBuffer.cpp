@@ -0,0 +1,117 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The G-buffer class
+*  Stores the first hit of the primary ray through each
+*  sample of the image, and reconstructs shaded colours at
+*  arbitrary image positions with an edge-aware filter.
+-------------------------------------------------------------*/
+
+#include "GBuffer.h"
+#include <math.h>
+
+const float NORMAL_TOL = 0.9f;   //Minimum cosine between normals on the same surface
+const float DEPTH_TOL = 0.1f;    //Maximum relative depth difference on the same surface
+
+/**
+* Two first hits lie on the same smooth surface if they hit the
+* same object with similar normals and similar depths.
+*/
+bool isCompatible(GSample& a, GSample& b)
+{
+    if (a.index != b.index) return false;
+    if (a.index == -1) return true;   //Both hit the background
+    if (glm::dot(a.normal, b.normal) < NORMAL_TOL) return false;
+    return fabs(a.depth - b.depth) <= DEPTH_TOL * fmax(a.depth, b.depth);
+}
+
+int GBuffer::getWidth()
+{
+    return width_;
+}
+
+int GBuffer::getHeight()
+{
+    return height_;
+}
+
+GSample& GBuffer::sampleAt(int i, int j)
+{
+    return samples_[j*width_ + i];
+}
+
+glm::vec3& GBuffer::colorAt(int i, int j)
+{
+    return colors_[j*width_ + i];
+}
+
+/**
+* Finds the 2x2 block of samples surrounding the position (x, y),
+* given in sample units, and the bilinear weights of its corners.
+*/
+static void footprint(int width, int height, float x, float y, int is[4], int js[4], float ws[4])
+{
+    float fx = x - 0.5f;
+    float fy = y - 0.5f;
+    int i0 = (int)floor(fx);
+    int j0 = (int)floor(fy);
+    float ax = fx - i0;
+    float ay = fy - j0;
+
+    for (int k = 0; k < 4; k++)
+    {
+        int i = i0 + (k & 1);
+        int j = j0 + (k >> 1);
+        is[k] = i < 0 ? 0 : (i > width-1 ? width-1 : i);
+        js[k] = j < 0 ? 0 : (j > height-1 ? height-1 : j);
+        ws[k] = ((k & 1) ? ax : 1-ax) * ((k >> 1) ? ay : 1-ay);
+    }
+}
+
+/**
+* Plain bilinear interpolation at (x, y), used when the four samples
+* surrounding it all lie on the same surface so that the position
+* does not need a primary ray of its own.  Returns false otherwise.
+*/
+bool GBuffer::interpolate(float x, float y, glm::vec3& color)
+{
+    int is[4], js[4];
+    float ws[4];
+    footprint(width_, height_, x, y, is, js, ws);
+
+    GSample& first = sampleAt(is[0], js[0]);
+    for (int k = 1; k < 4; k++)
+    {
+        if (!isCompatible(first, sampleAt(is[k], js[k]))) return false;
+    }
+
+    color = glm::vec3(0);
+    for (int k = 0; k < 4; k++) color += ws[k] * colorAt(is[k], js[k]);
+    return true;
+}
+
+/**
+* Joint bilateral upsampling: blends the colours of the four samples
+* surrounding (x, y) using bilinear weights, discarding samples whose
+* first hit is not compatible with 'hit'.  Returns false if none of
+* them are, i.e. the position lies on geometry the buffer missed.
+*/
+bool GBuffer::upsample(GSample& hit, float x, float y, glm::vec3& color)
+{
+    int is[4], js[4];
+    float ws[4];
+    footprint(width_, height_, x, y, is, js, ws);
+
+    glm::vec3 sum(0);
+    float wsum = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        if (!isCompatible(hit, sampleAt(is[k], js[k]))) continue;
+        float w = ws[k] + 1.e-4f;    //Keeps a compatible sample usable at zero bilinear weight
+        sum += w * colorAt(is[k], js[k]);
+        wsum += w;
+    }
+    if (wsum == 0) return false;
+    color = sum / wsum;
+    return true;
+}
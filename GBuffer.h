@@ -0,0 +1,53 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The G-buffer class
+*  Stores the first hit of the primary ray through each
+*  sample of the image (object index, normal and depth), so
+*  that a shaded image can be reconstructed at a higher
+*  resolution without crossing object or normal edges.
+-------------------------------------------------------------*/
+
+#ifndef H_GBUFFER
+#define H_GBUFFER
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * First-hit record of a single primary ray.
+ * index is -1 when the ray hits nothing.
+ */
+struct GSample
+{
+    int index = -1;                     //Ray::index of the first hit
+    glm::vec3 normal = glm::vec3(0);    //SceneObject::normal at the hit
+    float depth = 0;                    //Distance from the eye to the hit
+};
+
+class GBuffer
+{
+private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<GSample> samples_;
+    std::vector<glm::vec3> colors_;
+
+public:
+    GBuffer() = default;
+
+    GBuffer(int width, int height) :
+        width_(width), height_(height), samples_(width*height), colors_(width*height) {}
+
+    int getWidth();
+    int getHeight();
+
+    GSample& sampleAt(int i, int j);
+    glm::vec3& colorAt(int i, int j);
+
+    bool upsample(GSample& hit, float x, float y, glm::vec3& color);
+    bool interpolate(float x, float y, glm::vec3& color);
+};
+
+bool isCompatible(GSample& a, GSample& b);
+
+#endif //!H_GBUFFER
@@ -0,0 +1,72 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The image class
+-------------------------------------------------------------*/
+
+#include "Image.h"
+#include <fstream>
+#include <iostream>
+
+int Image::getWidth()
+{
+    return width_;
+}
+
+int Image::getHeight()
+{
+    return height_;
+}
+
+int Image::getX0()
+{
+    return x0_;
+}
+
+int Image::getY0()
+{
+    return y0_;
+}
+
+glm::vec3& Image::at(int i, int j)
+{
+    return pixels_[(j - y0_)*width_ + (i - x0_)];
+}
+
+/**
+* Converts a colour component to a byte, clamping to [0, 1].
+*/
+unsigned char Image::toByte(float c)
+{
+    if (c < 0) c = 0;
+    if (c > 1) c = 1;
+    return (unsigned char)(c * 255 + 0.5f);
+}
+
+/**
+* Writes the image as a binary PPM file, top row first.
+*/
+bool Image::writePPM(const char* filename)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    if (!file)
+    {
+        std::cout << "*** Error opening image file: " << filename << std::endl;
+        return false;
+    }
+    file << "P6\n" << width_ << " " << height_ << "\n255\n";
+
+    std::vector<unsigned char> row(3*width_);
+    for (int j = height_-1; j >= 0; j--)
+    {
+        for (int i = 0; i < width_; i++)
+        {
+            glm::vec3& col = pixels_[j*width_ + i];
+            row[3*i] = toByte(col.r);
+            row[3*i + 1] = toByte(col.g);
+            row[3*i + 2] = toByte(col.b);
+        }
+        file.write((char*)row.data(), row.size());
+    }
+    return (bool)file;
+}
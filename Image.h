@@ -0,0 +1,47 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The image class
+*  A grid of RGB colours produced by a render.  Cell (i, j)
+*  is column i and row j, counted from the bottom-left
+*  corner as on the OpenGL image plane.  An image may also
+*  hold just a part of a larger one, such as a tile, with
+*  its bottom-left cell at (x0, y0).
+-------------------------------------------------------------*/
+
+#ifndef H_IMAGE
+#define H_IMAGE
+#include <glm/glm.hpp>
+#include <vector>
+
+class Image
+{
+private:
+    int width_ = 0;
+    int height_ = 0;
+    int x0_ = 0;        //Cell (x0_, y0_) is pixels_[0]
+    int y0_ = 0;
+    std::vector<glm::vec3> pixels_;
+
+public:
+    Image() = default;
+
+    Image(int width, int height) :
+        width_(width), height_(height), pixels_(width*height) {}
+
+    Image(int width, int height, int x0, int y0) :
+        width_(width), height_(height), x0_(x0), y0_(y0), pixels_(width*height) {}
+
+    int getWidth();
+    int getHeight();
+    int getX0();
+    int getY0();
+
+    glm::vec3& at(int i, int j);
+
+    bool writePPM(const char* filename);
+
+    static unsigned char toByte(float c);
+};
+
+#endif //!H_IMAGE
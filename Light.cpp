@@ -0,0 +1,40 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The light shape
+-------------------------------------------------------------*/
+
+#include "Light.h"
+#include <math.h>
+
+int LightShape::isArea() const
+{
+    return type != LIGHT_POINT;
+}
+
+/**
+* Point of the light, centred on 'center', for the coordinates uv in [0, 1)^2.
+* Uniform uv give points spread evenly over the light as seen from 'from': a
+* sphere is sampled on its disc facing that point.
+*/
+glm::vec3 LightShape::point(glm::vec3 center, glm::vec3 from, glm::vec2 uv) const
+{
+    switch (type)
+    {
+        case LIGHT_RECT:
+            return center + (uv.x - 0.5f) * edgeU + (uv.y - 0.5f) * edgeV;
+
+        case LIGHT_SPHERE:
+        {
+            glm::vec3 w = glm::normalize(center - from);
+            glm::vec3 a = glm::normalize(glm::cross(fabsf(w.x) > 0.9f ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0), w));
+            glm::vec3 b = glm::cross(w, a);
+            float r = radius * sqrtf(uv.x);
+            float phi = 6.2831853f * uv.y;
+            return center + r * (cosf(phi) * a + sinf(phi) * b);
+        }
+
+        default:
+            return center;
+    }
+}
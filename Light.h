@@ -0,0 +1,35 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The light shape
+*  The scene's light is a point at Scene::lightPos unless
+*  it is given a shape: a rectangle or a sphere centred on
+*  lightPos.  Shaped (area) lights cast soft shadows, found
+*  by sending shadow rays to points spread over the light.
+*  Phong shading still treats the light as a point at its
+*  centre.
+-------------------------------------------------------------*/
+
+#ifndef H_LIGHT
+#define H_LIGHT
+#include <glm/glm.hpp>
+
+enum LightType
+{
+    LIGHT_POINT,
+    LIGHT_RECT,         //Parallelogram with sides edgeU and edgeV
+    LIGHT_SPHERE        //Sphere of the given radius
+};
+
+struct LightShape
+{
+    LightType type = LIGHT_POINT;
+    glm::vec3 edgeU = glm::vec3(0);     //Sides of a rectangular light
+    glm::vec3 edgeV = glm::vec3(0);
+    float radius = 0;                   //Radius of a spherical light
+
+    int isArea() const;
+    glm::vec3 point(glm::vec3 center, glm::vec3 from, glm::vec2 uv) const;
+};
+
+#endif //!H_LIGHT
@@ -0,0 +1,566 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The mapped mesh class
+-------------------------------------------------------------*/
+
+#include "MappedMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const char MESH_MAGIC[8] = {'R', 'T', 'M', 'E', 'S', 'H', '0', '1'};
+const int MESH_LEAF = 4;            //Most triangles in a leaf of a cluster's tree
+const int STACK_SIZE = 64;          //Deepest tree intersect() can walk (trees are balanced)
+const float BOX_PAD = 1.e-4f;       //Relative padding of boxes, so rounding never loses a hit
+const float MIN_HIT = 1.e-3f;       //Nearer hits are the surface a ray leaves from
+const long PAGE = 4096;             //Clusters start on page boundaries
+
+struct MeshBox
+{
+    glm::vec3 lo, hi, centre;
+};
+
+//---Fills nodes[index] with a tree over the items order[begin .. end-1] -----------
+//   Items are split at the median of the longest axis of their centres until at
+//     most leafSize are left; children are made in pairs, so the tree is balanced.
+//----------------------------------------------------------------------------------
+static void buildNodes(std::vector<MeshNode>& nodes, int index, std::vector<int>& order, int begin, int end,
+                       const std::vector<MeshBox>& items, int leafSize)
+{
+    glm::vec3 lo = items[order[begin]].lo, hi = items[order[begin]].hi;
+    glm::vec3 clo = items[order[begin]].centre, chi = clo;
+    for (int i = begin + 1; i < end; i++)
+    {
+        const MeshBox& b = items[order[i]];
+        lo = glm::min(lo, b.lo);
+        hi = glm::max(hi, b.hi);
+        clo = glm::min(clo, b.centre);
+        chi = glm::max(chi, b.centre);
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        nodes[index].lo[axis] = lo[axis];
+        nodes[index].hi[axis] = hi[axis];
+    }
+    if (end - begin <= leafSize)
+    {
+        nodes[index].first = begin;
+        nodes[index].count = end - begin;
+        return;
+    }
+
+    glm::vec3 extent = chi - clo;
+    int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z) ? 1 : 2;
+    int mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&](int a, int b) { return items[a].centre[axis] < items[b].centre[axis]; });
+
+    int left = (int)nodes.size();
+    nodes.resize(left + 2);
+    nodes[index].first = left;
+    nodes[index].count = 0;
+    buildNodes(nodes, left, order, begin, mid, items, leafSize);
+    buildNodes(nodes, left + 1, order, mid, end, items, leafSize);
+}
+
+//Ray parameter at which the ray enters the box, or -1 if it misses it before tmax (as in BVH.cpp)
+static inline float entry(const float* lo, const float* hi, const glm::vec3& p0, const glm::vec3& inv, float tmax)
+{
+    float tnear = 0, tfar = tmax;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float t1 = (lo[axis] - p0[axis]) * inv[axis];
+        float t2 = (hi[axis] - p0[axis]) * inv[axis];
+        float a = (t1 < t2) ? t1 : t2;
+        float b = (t1 < t2) ? t2 : t1;
+        if (a > tnear) tnear = a;
+        if (b < tfar) tfar = b;
+    }
+    return (tnear <= tfar) ? tnear : -1;
+}
+
+//Ray parameter of the hit on a triangle (Moller-Trumbore), or -1
+static inline float hitTriangle(const MeshTriangle& tri, const glm::vec3& p0, const glm::vec3& dir)
+{
+    glm::vec3 a(tri.v[0][0], tri.v[0][1], tri.v[0][2]);
+    glm::vec3 e1 = glm::vec3(tri.v[1][0], tri.v[1][1], tri.v[1][2]) - a;
+    glm::vec3 e2 = glm::vec3(tri.v[2][0], tri.v[2][1], tri.v[2][2]) - a;
+    glm::vec3 pv = glm::cross(dir, e2);
+    float det = glm::dot(e1, pv);
+    if (det == 0) return -1;
+    float invDet = 1.0f / det;
+    glm::vec3 tv = p0 - a;
+    float u = glm::dot(tv, pv) * invDet;
+    if (u < 0 || u > 1) return -1;
+    glm::vec3 qv = glm::cross(tv, e1);
+    float v = glm::dot(dir, qv) * invDet;
+    if (v < 0 || u + v > 1) return -1;
+    return glm::dot(e2, qv) * invDet;
+}
+
+//Unit normal of a triangle, by its winding as for a Plane
+static glm::vec3 triangleNormal(const MeshTriangle& tri)
+{
+    glm::vec3 a(tri.v[0][0], tri.v[0][1], tri.v[0][2]);
+    glm::vec3 b(tri.v[1][0], tri.v[1][1], tri.v[1][2]);
+    glm::vec3 c(tri.v[2][0], tri.v[2][1], tri.v[2][2]);
+    return glm::normalize(glm::cross(c - b, a - b));
+}
+
+//Whether a point in the plane of a triangle, of normal n, lies inside it (as Plane::isInside())
+static bool inside(const MeshTriangle& tri, glm::vec3 q, glm::vec3 n)
+{
+    glm::vec3 a(tri.v[0][0], tri.v[0][1], tri.v[0][2]);
+    glm::vec3 b(tri.v[1][0], tri.v[1][1], tri.v[1][2]);
+    glm::vec3 c(tri.v[2][0], tri.v[2][1], tri.v[2][2]);
+    float tolerance = -BOX_PAD * glm::dot(glm::cross(b - a, c - a), n);
+    return glm::dot(glm::cross(b - a, q - a), n) >= tolerance && glm::dot(glm::cross(c - b, q - b), n) >= tolerance &&
+           glm::dot(glm::cross(a - c, q - c), n) >= tolerance;
+}
+
+//The last hit found on a mesh by this thread, which normal() is usually asked about next
+struct LastHit
+{
+    const MappedMesh* mesh = nullptr;
+    glm::vec3 point, normal;
+};
+static thread_local LastHit lastHit;
+
+MappedMesh::MappedMesh() : clock_(0)
+{
+}
+
+MappedMesh::~MappedMesh()
+{
+    close();
+}
+
+//---Maps a mesh file made by write() ----------------------------------------------
+//   Clusters are paged in as rays reach them, keeping those paged in to
+//     budgetBytes (but always the one in use).  The boxes of the clusters are
+//     read now, and a tree is built over them in memory.
+//----------------------------------------------------------------------------------
+bool MappedMesh::open(const char* filename, size_t budgetBytes)
+{
+    close();
+    fd_ = ::open(filename, O_RDONLY);
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (fd_ >= 0 && fstat(fd_, &info) == 0 && (size_t)info.st_size >= sizeof(MeshFileHeader))
+        memory = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (memory == MAP_FAILED)
+    {
+        std::cout << "*** Error opening mesh file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    map_ = (const unsigned char*)memory;
+    size_ = info.st_size;
+    madvise(memory, size_, MADV_RANDOM);                //Read only the pages of the clusters rays reach
+
+    header_ = (const MeshFileHeader*)map_;
+    clusters_ = (const MeshCluster*)(map_ + sizeof(MeshFileHeader));
+    bool valid = memcmp(header_->magic, MESH_MAGIC, sizeof(MESH_MAGIC)) == 0 && header_->clusterCount > 0 &&
+                 sizeof(MeshFileHeader) + header_->clusterCount * sizeof(MeshCluster) <= size_;
+    for (int c = 0; valid && c < header_->clusterCount; c++)
+    {
+        const MeshCluster& cl = clusters_[c];
+        valid = cl.offset % PAGE == 0 && cl.nodeCount > 0 && cl.triangleCount > 0 &&
+                cl.bytes == (int64_t)(cl.nodeCount * sizeof(MeshNode) + cl.triangleCount * sizeof(MeshTriangle)) &&
+                cl.offset + cl.bytes <= (int64_t)size_;
+    }
+    if (!valid)
+    {
+        std::cout << "*** Not a mesh file: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    int count = header_->clusterCount;
+    std::vector<MeshBox> boxes(count);
+    order_.resize(count);
+    for (int c = 0; c < count; c++)
+    {
+        boxes[c].lo = glm::vec3(clusters_[c].lo[0], clusters_[c].lo[1], clusters_[c].lo[2]);
+        boxes[c].hi = glm::vec3(clusters_[c].hi[0], clusters_[c].hi[1], clusters_[c].hi[2]);
+        boxes[c].centre = 0.5f * (boxes[c].lo + boxes[c].hi);
+        order_[c] = c;
+    }
+    top_.assign(1, MeshNode());
+    buildNodes(top_, 0, order_, 0, count, boxes, 1);
+
+    residency_.reset(new Residency[count]);
+    for (int c = 0; c < count; c++)
+    {
+        residency_[c].resident.store(false);
+        residency_[c].lastUse.store(0);
+    }
+    stats_ = MeshStats();
+    stats_.clusters = count;
+    stats_.triangles = header_->triangleCount;
+    stats_.budgetBytes = budgetBytes;
+    stats_.fileBytes = size_;
+    return true;
+}
+
+void MappedMesh::close()
+{
+    if (map_ != nullptr) munmap((void*)map_, size_);
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    map_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    clusters_ = nullptr;
+    top_.clear();
+    order_.clear();
+    residency_.reset();
+    if (lastHit.mesh == this) lastHit.mesh = nullptr;
+}
+
+//---Marks cluster c in use, paging it in if it is not resident --------------------
+//   Paging in counts a fault, then evicts the least recently used clusters
+//     until the resident ones fit the budget again.  Evicted pages stay mapped:
+//     a thread still reading one has it read from the file again.
+//----------------------------------------------------------------------------------
+const unsigned char* MappedMesh::touch(int c)
+{
+    Residency& r = residency_[c];
+    r.lastUse.store(clock_.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    const unsigned char* data = map_ + clusters_[c].offset;
+    if (r.resident.load(std::memory_order_acquire)) return data;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (r.resident.load(std::memory_order_relaxed)) return data;
+    madvise((void*)data, clusters_[c].bytes, MADV_WILLNEED);
+    r.resident.store(true, std::memory_order_release);
+    stats_.faults++;
+    stats_.residentBytes += clusters_[c].bytes;
+
+    while (stats_.residentBytes > stats_.budgetBytes)
+    {
+        int victim = -1;
+        uint64_t oldest = 0;
+        for (int k = 0; k < stats_.clusters; k++)
+        {
+            if (k == c || !residency_[k].resident.load(std::memory_order_relaxed)) continue;
+            uint64_t use = residency_[k].lastUse.load(std::memory_order_relaxed);
+            if (victim < 0 || use < oldest)
+            {
+                victim = k;
+                oldest = use;
+            }
+        }
+        if (victim < 0) break;
+        residency_[victim].resident.store(false, std::memory_order_relaxed);
+        madvise((void*)(map_ + clusters_[victim].offset), clusters_[victim].bytes, MADV_DONTNEED);
+        stats_.evictions++;
+        stats_.residentBytes -= clusters_[victim].bytes;
+    }
+    stats_.peakResidentBytes = std::max(stats_.peakResidentBytes, stats_.residentBytes);
+    return data;
+}
+
+const MeshTriangle& MappedMesh::triangle(int c, int k)
+{
+    const unsigned char* data = touch(c);
+    return ((const MeshTriangle*)(data + clusters_[c].nodeCount * sizeof(MeshNode)))[k];
+}
+
+//Lowers tmin to the nearest hit in cluster c, setting hit to its triangle
+void MappedMesh::closestInCluster(int c, glm::vec3 p0, glm::vec3 dir, glm::vec3 inv, float& tmin, int& hit)
+{
+    const unsigned char* data = touch(c);
+    const MeshNode* nodes = (const MeshNode*)data;
+    const MeshTriangle* tris = (const MeshTriangle*)(data + clusters_[c].nodeCount * sizeof(MeshNode));
+
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const MeshNode& node = nodes[stack[--top]];
+        if (entry(node.lo, node.hi, p0, inv, tmin) < 0) continue;
+        if (node.count > 0)
+        {
+            for (int k = node.first; k < node.first + node.count; k++)
+            {
+                float t = hitTriangle(tris[k], p0, dir);
+                if (t > MIN_HIT && t < tmin)
+                {
+                    tmin = t;
+                    hit = k;
+                }
+            }
+        }
+        else if (top + 2 <= STACK_SIZE)
+        {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+        }
+    }
+}
+
+/**
+* Nearest hit of the ray on the mesh, or -1.  Clusters are visited nearest
+* box first, and only while they can hold a nearer hit.
+*/
+float MappedMesh::intersect(glm::vec3 p0, glm::vec3 dir)
+{
+    if (top_.empty()) return -1;
+    glm::vec3 inv = 1.0f / dir;
+    float tmin = std::numeric_limits<float>::max();
+    int hitCluster = -1, hit = -1;
+
+    int stack[STACK_SIZE];
+    float stackEntry[STACK_SIZE];
+    int top = 0;
+    float t0 = entry(top_[0].lo, top_[0].hi, p0, inv, tmin);
+    if (t0 < 0) return -1;
+    stack[top] = 0;
+    stackEntry[top++] = t0;
+    while (top > 0)
+    {
+        top--;
+        if (stackEntry[top] > tmin) continue;
+        const MeshNode& node = top_[stack[top]];
+        if (node.count > 0)
+        {
+            int c = order_[node.first];
+            int before = hit;
+            closestInCluster(c, p0, dir, inv, tmin, hit);
+            if (hit != before) hitCluster = c;
+            continue;
+        }
+        float tl = entry(top_[node.first].lo, top_[node.first].hi, p0, inv, tmin);
+        float tr = entry(top_[node.first + 1].lo, top_[node.first + 1].hi, p0, inv, tmin);
+        if (top + 2 > STACK_SIZE) continue;
+        if (tl >= 0 && tr >= 0 && tr < tl)          //Nearer child popped first
+        {
+            stack[top] = node.first;
+            stackEntry[top++] = tl;
+            stack[top] = node.first + 1;
+            stackEntry[top++] = tr;
+        }
+        else
+        {
+            if (tr >= 0)
+            {
+                stack[top] = node.first + 1;
+                stackEntry[top++] = tr;
+            }
+            if (tl >= 0)
+            {
+                stack[top] = node.first;
+                stackEntry[top++] = tl;
+            }
+        }
+    }
+    if (hitCluster < 0) return -1;
+
+    lastHit.mesh = this;
+    lastHit.point = p0 + dir * tmin;
+    lastHit.normal = triangleNormal(triangle(hitCluster, hit));
+    return tmin;
+}
+
+/**
+* Unit normal at a point on the mesh.  Usually the point is the last hit this
+* thread found; otherwise it is the normal of the triangle nearest the point
+* among those whose boxes hold it.
+*/
+glm::vec3 MappedMesh::normal(glm::vec3 p)
+{
+    if (lastHit.mesh == this && lastHit.point == p) return lastHit.normal;
+    if (top_.empty()) return glm::vec3(0, 1, 0);
+
+    glm::vec3 n(0, 1, 0);
+    float best = std::numeric_limits<float>::max();
+    float pad = BOX_PAD * (std::max(std::max(std::fabs(p.x), std::fabs(p.y)), std::fabs(p.z)) + 1);
+    auto holds = [&](const MeshNode& node) {
+        for (int axis = 0; axis < 3; axis++)
+            if (p[axis] < node.lo[axis] - pad || p[axis] > node.hi[axis] + pad) return false;
+        return true;
+    };
+
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const MeshNode& node = top_[stack[--top]];
+        if (!holds(node)) continue;
+        if (node.count == 0)
+        {
+            if (top + 2 > STACK_SIZE) continue;
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+            continue;
+        }
+
+        int c = order_[node.first];
+        const unsigned char* data = touch(c);
+        const MeshNode* nodes = (const MeshNode*)data;
+        const MeshTriangle* tris = (const MeshTriangle*)(data + clusters_[c].nodeCount * sizeof(MeshNode));
+        int inner[STACK_SIZE];
+        int innerTop = 0;
+        inner[innerTop++] = 0;
+        while (innerTop > 0)
+        {
+            const MeshNode& in = nodes[inner[--innerTop]];
+            if (!holds(in)) continue;
+            if (in.count == 0)
+            {
+                if (innerTop + 2 > STACK_SIZE) continue;
+                inner[innerTop++] = in.first;
+                inner[innerTop++] = in.first + 1;
+                continue;
+            }
+            for (int k = in.first; k < in.first + in.count; k++)
+            {
+                glm::vec3 tn = triangleNormal(tris[k]);
+                float d = std::fabs(glm::dot(p - glm::vec3(tris[k].v[0][0], tris[k].v[0][1], tris[k].v[0][2]), tn));
+                if (!inside(tris[k], p - d * tn, tn) && !inside(tris[k], p + d * tn, tn)) d += pad + best;
+                if (d < best)
+                {
+                    best = d;
+                    n = tn;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+void MappedMesh::bounds(glm::vec3& lo, glm::vec3& hi)
+{
+    if (header_ == nullptr)
+    {
+        lo = hi = glm::vec3(0);
+        return;
+    }
+    lo = glm::vec3(header_->lo[0], header_->lo[1], header_->lo[2]);
+    hi = glm::vec3(header_->hi[0], header_->hi[1], header_->hi[2]);
+}
+
+MeshStats MappedMesh::getStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+//---Writes a mesh file of the triangles (i, j, k) of vertices in indices ----------
+//   Triangles are split into spatially coherent clusters of at most
+//     clusterTriangles, each given its own tree and written from a page boundary.
+//     The whole mesh is held in memory while it is written.
+//----------------------------------------------------------------------------------
+bool MappedMesh::write(const char* filename, std::vector<glm::vec3>& vertices, std::vector<int>& indices,
+                       int clusterTriangles)
+{
+    int count = (int)(indices.size() / 3);
+    for (int i = 0; i < 3 * count; i++)
+        if (indices[i] < 0 || indices[i] >= (int)vertices.size())
+        {
+            std::cout << "*** Error writing mesh file: vertex index " << indices[i] << " out of range" << std::endl;
+            return false;
+        }
+    if (count == 0)
+    {
+        std::cout << "*** Error writing mesh file: no triangles" << std::endl;
+        return false;
+    }
+
+    std::vector<MeshBox> boxes(count);
+    std::vector<int> order(count);
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 a = vertices[indices[3 * i]], b = vertices[indices[3 * i + 1]], c = vertices[indices[3 * i + 2]];
+        glm::vec3 lo = glm::min(glm::min(a, b), c), hi = glm::max(glm::max(a, b), c);
+        glm::vec3 pad = BOX_PAD * (glm::max(glm::abs(lo), glm::abs(hi)) + glm::vec3(1));
+        boxes[i].lo = lo - pad;
+        boxes[i].hi = hi + pad;
+        boxes[i].centre = (a + b + c) * (1.0f / 3);
+        order[i] = i;
+    }
+
+    //The leaves of a tree over all the triangles are the clusters
+    std::vector<MeshNode> split(1);
+    buildNodes(split, 0, order, 0, count, boxes, std::max(1, clusterTriangles));
+    std::vector<MeshCluster> clusters;
+    for (MeshNode& node : split)
+    {
+        if (node.count == 0) continue;
+        MeshCluster cl;
+        memcpy(cl.lo, node.lo, sizeof(cl.lo));
+        memcpy(cl.hi, node.hi, sizeof(cl.hi));
+        cl.nodeCount = node.first;              //First triangle, until the cluster is built
+        cl.triangleCount = node.count;
+        clusters.push_back(cl);
+    }
+
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+    header.clusterCount = (int)clusters.size();
+    header.triangleCount = count;
+    memcpy(header.lo, split[0].lo, sizeof(header.lo));
+    memcpy(header.hi, split[0].hi, sizeof(header.hi));
+
+    FILE* file = fopen(filename, "wb");
+    if (file == nullptr)
+    {
+        std::cout << "*** Error writing mesh file: " << filename << std::endl;
+        return false;
+    }
+    long offset = sizeof(MeshFileHeader) + clusters.size() * sizeof(MeshCluster);
+    offset = (offset + PAGE - 1) / PAGE * PAGE;
+    bool ok = fseek(file, offset, SEEK_SET) == 0;
+
+    for (int c = 0; ok && c < (int)clusters.size(); c++)
+    {
+        MeshCluster& cl = clusters[c];
+        int first = cl.nodeCount;
+        std::vector<int> local(order.begin() + first, order.begin() + first + cl.triangleCount);
+        std::vector<int> localOrder(cl.triangleCount);
+        std::vector<MeshBox> localBoxes(cl.triangleCount);
+        for (int k = 0; k < cl.triangleCount; k++)
+        {
+            localBoxes[k] = boxes[local[k]];
+            localOrder[k] = k;
+        }
+        std::vector<MeshNode> nodes(1);
+        buildNodes(nodes, 0, localOrder, 0, cl.triangleCount, localBoxes, MESH_LEAF);
+
+        std::vector<MeshTriangle> tris(cl.triangleCount);
+        for (int k = 0; k < cl.triangleCount; k++)
+            for (int v = 0; v < 3; v++)
+            {
+                glm::vec3 p = vertices[indices[3 * local[localOrder[k]] + v]];
+                tris[k].v[v][0] = p.x;
+                tris[k].v[v][1] = p.y;
+                tris[k].v[v][2] = p.z;
+            }
+
+        cl.offset = offset;
+        cl.nodeCount = (int)nodes.size();
+        cl.bytes = nodes.size() * sizeof(MeshNode) + tris.size() * sizeof(MeshTriangle);
+        ok = fseek(file, offset, SEEK_SET) == 0 &&
+             fwrite(nodes.data(), sizeof(MeshNode), nodes.size(), file) == nodes.size() &&
+             fwrite(tris.data(), sizeof(MeshTriangle), tris.size(), file) == tris.size();
+        offset = (offset + cl.bytes + PAGE - 1) / PAGE * PAGE;
+    }
+
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1 &&
+         fwrite(clusters.data(), sizeof(MeshCluster), clusters.size(), file) == clusters.size();
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) std::cout << "*** Error writing mesh file: " << filename << std::endl;
+    return ok;
+}
@@ -0,0 +1,123 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The mapped mesh class
+*  A triangle mesh that stays in a file, mapped into memory,
+*  so that it can be larger than RAM.  The file splits the
+*  triangles into spatially coherent clusters, each with
+*  its own small BVH, on page boundaries.  Only the boxes of
+*  the clusters are held in memory.  A cluster is paged in
+*  when a ray first enters it; once the clusters in use pass
+*  the resident budget, the least recently used are given
+*  back to the system (madvise), to be read again if a ray
+*  returns to them.  MeshStats counts these faults and
+*  evictions.
+*
+*  To the scene the mesh is one object of one material.
+*  write() makes a mesh file from triangles in memory; see
+*  MeshPack for converting .obj files.
+-------------------------------------------------------------*/
+
+#ifndef H_MAPPEDMESH
+#define H_MAPPEDMESH
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "SceneObject.h"
+
+const int MESH_CLUSTER_TRIANGLES = 4096;                //Triangles per cluster, by default
+const size_t MESH_BUDGET_BYTES = (size_t)256 << 20;     //Resident clusters, by default
+
+struct MeshStats
+{
+    int clusters = 0;
+    long triangles = 0;
+    long faults = 0;                //Clusters paged in, including again after eviction
+    long evictions = 0;
+    size_t residentBytes = 0;       //Clusters paged in now
+    size_t peakResidentBytes = 0;
+    size_t budgetBytes = 0;
+    size_t fileBytes = 0;
+};
+
+//Layout of a mesh file: a MeshFileHeader, clusterCount MeshClusters, then the clusters' data
+struct MeshFileHeader
+{
+    char magic[8];
+    int32_t clusterCount;
+    int32_t unused;
+    int64_t triangleCount;
+    float lo[3], hi[3];
+};
+
+struct MeshCluster
+{
+    float lo[3], hi[3];
+    int64_t offset;                 //Of the cluster's nodes, on a page boundary, followed by its triangles
+    int32_t nodeCount;
+    int32_t triangleCount;
+    int64_t bytes;
+};
+
+struct MeshNode
+{
+    float lo[3], hi[3];
+    int32_t first;                  //Leaf: first item; internal: left child, the right one following it
+    int32_t count;                  //Items of a leaf; 0 for internal nodes
+};
+
+struct MeshTriangle
+{
+    float v[3][3];
+};
+
+class MappedMesh : public SceneObject
+{
+private:
+    struct Residency
+    {
+        std::atomic<bool> resident;
+        std::atomic<uint64_t> lastUse;
+    };
+
+    int fd_ = -1;
+    const unsigned char* map_ = nullptr;
+    size_t size_ = 0;
+    const MeshFileHeader* header_ = nullptr;
+    const MeshCluster* clusters_ = nullptr;
+    std::vector<MeshNode> top_;                 //BVH over the clusters; leaves hold clusters order_[first]
+    std::vector<int> order_;
+    std::unique_ptr<Residency[]> residency_;
+    std::atomic<uint64_t> clock_;
+    std::mutex mutex_;                          //Guards stats_ and paging in and out
+    MeshStats stats_;
+
+    const unsigned char* touch(int c);
+    void closestInCluster(int c, glm::vec3 p0, glm::vec3 dir, glm::vec3 inv, float& tmin, int& hit);
+    const MeshTriangle& triangle(int c, int k);
+
+public:
+    MappedMesh();
+    ~MappedMesh();
+
+    MappedMesh(const MappedMesh&) = delete;
+    MappedMesh& operator=(const MappedMesh&) = delete;
+
+    bool open(const char* filename, size_t budgetBytes = MESH_BUDGET_BYTES);
+    void close();
+
+    float intersect(glm::vec3 p0, glm::vec3 dir);
+    glm::vec3 normal(glm::vec3 p);
+    void bounds(glm::vec3& lo, glm::vec3& hi);
+
+    MeshStats getStats();
+
+    static bool write(const char* filename, std::vector<glm::vec3>& vertices, std::vector<int>& indices,
+                      int clusterTriangles = MESH_CLUSTER_TRIANGLES);
+};
+
+#endif //!H_MAPPEDMESH
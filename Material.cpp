@@ -0,0 +1,39 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The material classes
+*  Colour sources evaluated at each point of intersection.
+-------------------------------------------------------------*/
+
+#include "Material.h"
+#include <math.h>
+
+/**
+* Returns the colour of the checker cell containing the hit point.
+*/
+glm::vec3 CheckerMaterial::colorAt(SceneObject* obj, glm::vec3 hit)
+{
+    int iz = (hit.z) / stripeWidth_;
+    int ix = (hit.x) / stripeWidth_;
+
+    int k = abs(iz % 2);
+    int l = abs(ix % 2);
+
+    if (hit.x < 0) l = abs((ix + 1) % 2);
+
+    return (k == l) ? color1_ : color2_;
+}
+
+/**
+* Returns the texel at the spherical coordinates (u, v) of the
+* object's normal at the hit point.
+*/
+glm::vec3 TextureMaterial::colorAt(SceneObject* obj, glm::vec3 hit)
+{
+    glm::vec3 n = obj->normal(hit);
+
+    float u = 0.5 + atan2(n.x, n.z)/(2*M_PI);
+    float v = 0.5 - asin(n.y)/M_PI;
+
+    return texture_->getColorAt(u, v);
+}
@@ -0,0 +1,61 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The material classes
+*  A material is a colour source evaluated at each point of
+*  intersection.  It returns the colour of the surface at
+*  that point without modifying the scene object, so any
+*  object can share a material and shading never writes to
+*  the scene.
+-------------------------------------------------------------*/
+
+#ifndef H_MATERIAL
+#define H_MATERIAL
+#include <glm/glm.hpp>
+#include "SceneObject.h"
+#include "TextureBMP.h"
+
+class Material
+{
+public:
+    virtual glm::vec3 colorAt(SceneObject* obj, glm::vec3 hit) = 0;
+    virtual ~Material() {}
+};
+
+/**
+ * Checkerboard of two colours in the xz-plane, with square
+ * cells of side 'stripeWidth'.
+ */
+class CheckerMaterial : public Material
+{
+private:
+    glm::vec3 color1_ = glm::vec3(1, 0, 0);
+    glm::vec3 color2_ = glm::vec3(0, 1, 0);
+    float stripeWidth_ = 5;
+
+public:
+    CheckerMaterial() {};
+
+    CheckerMaterial(glm::vec3 col1, glm::vec3 col2, float stripeWidth) :
+        color1_(col1), color2_(col2), stripeWidth_(stripeWidth) {}
+
+    glm::vec3 colorAt(SceneObject* obj, glm::vec3 hit);
+};
+
+/**
+ * Image texture wrapped around the object using spherical
+ * coordinates of the object's normal at the hit point.
+ * The texture is not owned by the material.
+ */
+class TextureMaterial : public Material
+{
+private:
+    TextureBMP* texture_ = nullptr;
+
+public:
+    TextureMaterial(TextureBMP* texture) : texture_(texture) {}
+
+    glm::vec3 colorAt(SceneObject* obj, glm::vec3 hit);
+};
+
+#endif //!H_MATERIAL
@@ -0,0 +1,92 @@
+/*==================================================================================
+* COSC 363  Computer Graphics
+* Department of Computer Science and Software Engineering, University of Canterbury.
+*
+* Mesh packer
+* Converts a Wavefront .obj file into a mesh file for MappedMesh: its clusters
+* of triangles, each with its own tree, on page boundaries.  Only vertices
+* ('v') and faces ('f') are read; faces of more than three vertices are split
+* into fans.  The mesh is held in memory while it is packed; rendering it
+* afterwards pages in only the clusters rays reach.
+*
+* Usage:  MeshPack.out <input.obj> <output.mesh> [triangles per cluster]
+*===================================================================================
+*/
+#include <iostream>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MappedMesh.h"
+using namespace std;
+
+//Reads the vertices and triangles of an .obj file; false if it cannot be read or a face is malformed
+static bool readOBJ(const char* filename, vector<glm::vec3>& vertices, vector<int>& indices)
+{
+    ifstream in(filename);
+    if (!in)
+    {
+        cout << "*** Error opening " << filename << endl;
+        return false;
+    }
+    string line;
+    long lineNumber = 0;
+    while (getline(in, line))
+    {
+        lineNumber++;
+        istringstream words(line);
+        string kind;
+        words >> kind;
+        if (kind == "v")
+        {
+            glm::vec3 v;
+            words >> v.x >> v.y >> v.z;
+            vertices.push_back(v);
+        }
+        else if (kind == "f")
+        {
+            vector<int> face;
+            string vertex;
+            while (words >> vertex)
+            {
+                int k = atoi(vertex.c_str());          //"k", "k/t", "k/t/n" or "k//n"
+                face.push_back(k < 0 ? (int)vertices.size() + k : k - 1);
+            }
+            if (face.size() < 3)
+            {
+                cout << "*** Error in " << filename << " line " << lineNumber << ": face of fewer than 3 vertices" << endl;
+                return false;
+            }
+            for (int i = 1; i + 1 < (int)face.size(); i++)
+            {
+                indices.push_back(face[0]);
+                indices.push_back(face[i]);
+                indices.push_back(face[i + 1]);
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        cout << "Usage: " << argv[0] << " <input.obj> <output.mesh> [triangles per cluster]" << endl;
+        return 1;
+    }
+    int clusterTriangles = (argc > 3) ? atoi(argv[3]) : MESH_CLUSTER_TRIANGLES;
+
+    vector<glm::vec3> vertices;
+    vector<int> indices;
+    if (!readOBJ(argv[1], vertices, indices)) return 1;
+    cout << argv[1] << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles" << endl;
+    if (!MappedMesh::write(argv[2], vertices, indices, clusterTriangles)) return 1;
+
+    MappedMesh mesh;
+    if (!mesh.open(argv[2])) return 1;
+    MeshStats stats = mesh.getStats();
+    cout << argv[2] << ": " << stats.clusters << " clusters, " << stats.fileBytes / 1024 << " KB" << endl;
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The PPM writer class
+-------------------------------------------------------------*/
+
+#include "PPMWriter.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+PPMWriter::~PPMWriter()
+{
+    close();
+}
+
+/**
+* Creates the file at its full size, with the header written and every
+* pixel black until its tile arrives.
+*/
+bool PPMWriter::open(const char* filename, int width, int height)
+{
+    close();
+    failed_ = false;
+    width_ = width;
+    height_ = height;
+
+    char header[64];
+    headerSize_ = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+
+    fd_ = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0 ||
+        ftruncate(fd_, headerSize_ + 3L * width * height) != 0 ||
+        pwrite(fd_, header, headerSize_, 0) != headerSize_)
+    {
+        std::cout << "*** Error opening image file: " << filename << std::endl;
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+//Writes the rows of a band, which are contiguous in the file
+void PPMWriter::writeBand(int y0, Band& band)
+{
+    off_t offset = headerSize_ + 3L * width_ * (height_ - band.y1);
+    size_t done = 0;
+    while (done < band.bytes.size())
+    {
+        ssize_t n = pwrite(fd_, band.bytes.data() + done, band.bytes.size() - done, offset + done);
+        if (n <= 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!failed_) std::cout << "*** Error writing image rows " << y0 << " to " << band.y1 - 1 << std::endl;
+            failed_ = true;
+            return;
+        }
+        done += n;
+    }
+}
+
+void PPMWriter::write(Tile& tile, Image& pixels)
+{
+    if (fd_ < 0) return;
+
+    Band finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = bands_.find(tile.y0);
+        if (it == bands_.end())
+        {
+            Band band;
+            band.y1 = tile.y1;
+            band.pixelsLeft = (long)width_ * (tile.y1 - tile.y0);
+            band.bytes.assign(3L * width_ * (tile.y1 - tile.y0), 0);
+            bufferBytes_ += band.bytes.size();
+            peakBufferBytes_ = std::max(peakBufferBytes_, bufferBytes_);
+            it = bands_.emplace(tile.y0, std::move(band)).first;
+        }
+        Band& band = it->second;
+
+        for (int j = tile.y0; j < tile.y1; j++)
+        {
+            unsigned char* row = &band.bytes[3L * (width_ * (band.y1 - 1 - j) + tile.x0)];
+            for (int i = tile.x0; i < tile.x1; i++)
+            {
+                glm::vec3& col = pixels.at(i, j);
+                *row++ = Image::toByte(col.r);
+                *row++ = Image::toByte(col.g);
+                *row++ = Image::toByte(col.b);
+            }
+        }
+        band.pixelsLeft -= (long)(tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+        if (band.pixelsLeft > 0) return;
+
+        finished = std::move(band);
+        bufferBytes_ -= finished.bytes.size();
+        bands_.erase(it);
+    }
+    writeBand(tile.y0, finished);
+}
+
+/**
+* Writes any bands still incomplete (the tiles of a cancelled render that
+* did finish) and closes the file.  Returns false if anything failed.
+*/
+bool PPMWriter::close()
+{
+    if (fd_ < 0) return !failed_;
+    for (auto& entry : bands_) writeBand(entry.first, entry.second);
+    bands_.clear();
+    bufferBytes_ = 0;
+    if (::close(fd_) != 0) failed_ = true;
+    fd_ = -1;
+    return !failed_;
+}
+
+//Most memory the bands held at once
+size_t PPMWriter::getPeakBufferBytes()
+{
+    return peakBufferBytes_;
+}
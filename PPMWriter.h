@@ -0,0 +1,56 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The PPM writer class
+*  A TileSink that streams a render into a binary PPM file,
+*  so that the full image never has to be in memory.  Tiles
+*  are gathered into bands of whole scanlines, and each band
+*  is written with one pwrite() as soon as its last tile
+*  arrives, then freed.  Renders finish tiles roughly in row
+*  order, so only a few bands are held at any time.
+-------------------------------------------------------------*/
+
+#ifndef H_PPMWRITER
+#define H_PPMWRITER
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "TileSink.h"
+
+class PPMWriter : public TileSink
+{
+private:
+    struct Band
+    {
+        int y1;                             //Rows [y0, y1), y0 being the key in bands_
+        long pixelsLeft;                    //Cells not written yet
+        std::vector<unsigned char> bytes;   //Scanlines of the band, top row first
+    };
+
+    int fd_ = -1;
+    int width_ = 0;
+    int height_ = 0;
+    long headerSize_ = 0;
+    std::map<int, Band> bands_;
+    std::mutex mutex_;
+    bool failed_ = false;
+    size_t bufferBytes_ = 0;
+    size_t peakBufferBytes_ = 0;
+
+    void writeBand(int y0, Band& band);
+
+public:
+    PPMWriter() = default;
+    ~PPMWriter();
+
+    PPMWriter(const PPMWriter&) = delete;
+    PPMWriter& operator=(const PPMWriter&) = delete;
+
+    bool open(const char* filename, int width, int height);
+    void write(Tile& tile, Image& pixels);
+    bool close();
+    size_t getPeakBufferBytes();
+};
+
+#endif //!H_PPMWRITER
@@ -67,11 +67,37 @@ bool Plane::isInside(glm::vec3 q)
 }
 
 
+/**
+* Returns the bounding box of the polygon's vertices.
+*/
+void Plane::bounds(glm::vec3& lo, glm::vec3& hi)
+{
+	lo = glm::min(glm::min(a_, b_), c_);
+	hi = glm::max(glm::max(a_, b_), c_);
+	if (nverts_ == 4)
+	{
+		lo = glm::min(lo, d_);
+		hi = glm::max(hi, d_);
+	}
+}
+
+
 //Getter function for number of vertices
 int  Plane::getNumVerts()
 {
 	return nverts_;
 }
 
+//Vertex k (0 to getNumVerts()-1), in order around the polygon
+glm::vec3 Plane::getVertex(int k)
+{
+	const glm::vec3* verts[4] = {&a_, &b_, &c_, &d_};
+	return *verts[k];
+}
+
+SceneObject* Plane::clone()
+{
+	return new Plane(*this);
+}
 
 
@@ -36,9 +36,15 @@ public:
 	float intersect(glm::vec3 posn, glm::vec3 dir);
 
 	int getNumVerts();
+
+	glm::vec3 getVertex(int k);
 	
 	glm::vec3 normal(glm::vec3 pt);
 
+	void bounds(glm::vec3& lo, glm::vec3& hi);
+
+	SceneObject* clone();
+
 };
 
 #endif //!H_PLANE
@@ -0,0 +1,90 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Render profiling
+-------------------------------------------------------------*/
+
+#include "Profile.h"
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+/**
+* False-colour image of one channel of a cost image, from black (no cost)
+* through purple, red and yellow to white (the highest cost).  The scale is
+* logarithmic, since a few cells such as those seen through refraction or
+* deeply anti-aliased can cost hundreds of times the rest.
+*/
+Image costHeatmap(Image& costs, CostChannel channel)
+{
+    const glm::vec3 ramp[5] = {glm::vec3(0), glm::vec3(0.4, 0, 0.6), glm::vec3(0.9, 0.1, 0.1),
+                               glm::vec3(1, 0.85, 0), glm::vec3(1)};
+    int width = costs.getWidth();
+    int height = costs.getHeight();
+    int x0 = costs.getX0();
+    int y0 = costs.getY0();
+
+    float peak = 0;
+    for (int j = y0; j < y0 + height; j++)
+        for (int i = x0; i < x0 + width; i++)
+            peak = std::max(peak, costs.at(i, j)[channel]);
+
+    Image heatmap(width, height, x0, y0);
+    for (int j = y0; j < y0 + height; j++)
+        for (int i = x0; i < x0 + width; i++)
+        {
+            float v = (peak > 0) ? log1pf(costs.at(i, j)[channel]) / log1pf(peak) * 4 : 0;
+            int k = std::min((int)v, 3);
+            heatmap.at(i, j) = glm::mix(ramp[k], ramp[k + 1], v - k);
+        }
+    return heatmap;
+}
+
+Timeline::Timeline() : origin_(std::chrono::steady_clock::now()) {}
+
+//Microseconds since the timeline was created
+double Timeline::now()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin_).count();
+}
+
+//Records that the calling thread worked on 'tile' from 'start' to 'end' (see now())
+void Timeline::record(const std::string& name, Tile tile, double start, double end)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = threads_.emplace(std::this_thread::get_id(), (int)threads_.size()).first;
+    events_.push_back({name, tile, it->second, start, end});
+}
+
+/**
+* Writes the events as complete ("X") events of the Chrome trace-event
+* format, one track per thread, with each tile's cells as arguments.
+*/
+bool Timeline::writeJSON(const char* filename)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ofstream out(filename);
+    if (!out)
+    {
+        std::cout << "*** Error writing timeline: " << filename << std::endl;
+        return false;
+    }
+
+    out << "{\"traceEvents\":[\n";
+    for (int t = 0; t < (int)threads_.size(); t++)
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+            << ",\"args\":{\"name\":\"worker " << t << "\"}},\n";
+    out.precision(15);
+    for (size_t k = 0; k < events_.size(); k++)
+    {
+        Event& e = events_[k];
+        out << "{\"name\":\"" << e.name << "\",\"cat\":\"render\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+            << ",\"ts\":" << e.start << ",\"dur\":" << e.end - e.start
+            << ",\"args\":{\"x0\":" << e.tile.x0 << ",\"y0\":" << e.tile.y0
+            << ",\"x1\":" << e.tile.x1 << ",\"y1\":" << e.tile.y1 << "}}"
+            << (k + 1 < events_.size() ? ",\n" : "\n");
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+    return (bool)out;
+}
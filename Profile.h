@@ -0,0 +1,60 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Render profiling
+*  Two optional records of where a render spends its time.
+*  A cost image (RenderSettings::costImage) holds, for each
+*  cell, the trace() calls, intersection tests and
+*  nanoseconds spent on it in its r, g and b components;
+*  costHeatmap() turns one of them into a false-colour
+*  image.  A Timeline (RenderSettings::timeline) records
+*  when each tile ran on which thread, and writes it as
+*  Chrome trace-event JSON (chrome://tracing, Perfetto).
+-------------------------------------------------------------*/
+
+#ifndef H_PROFILE
+#define H_PROFILE
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Image.h"
+#include "TileSink.h"
+
+enum CostChannel
+{
+    COST_TRACES,        //trace() calls, including primary rays
+    COST_TESTS,         //Ray-object intersection tests
+    COST_NANOS          //Time spent, in nanoseconds
+};
+
+Image costHeatmap(Image& costs, CostChannel channel);
+
+class Timeline
+{
+private:
+    struct Event
+    {
+        std::string name;
+        Tile tile;
+        int thread;
+        double start;       //Microseconds since the timeline was created
+        double end;
+    };
+
+    std::chrono::steady_clock::time_point origin_;
+    std::vector<Event> events_;
+    std::map<std::thread::id, int> threads_;   //Small numbers for thread ids, in order of appearance
+    std::mutex mutex_;
+
+public:
+    Timeline();
+
+    double now();
+    void record(const std::string& name, Tile tile, double start, double end);
+    bool writeJSON(const char* filename);
+};
+
+#endif //!H_PROFILE
@@ -0,0 +1,136 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Quadrics
+-------------------------------------------------------------*/
+
+#include "Quadric.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QUADRIC_AVX2
+#endif
+
+void QuadricPack::clear()
+{
+    memset(this, 0, sizeof(QuadricPack));       //Spheres of radius 0
+}
+
+//Puts q in a lane, with its coefficients worked out as its intersect() does
+void QuadricPack::set(int lane, const Quadric& q)
+{
+    cx[lane] = q.centre.x;
+    cy[lane] = q.centre.y;
+    cz[lane] = q.centre.z;
+    height[lane] = q.height;
+    shape[lane] = (q.shape == QUADRIC_CYLINDER && q.cap) ? QUADRIC_CAPPED_CYLINDER : q.shape;
+    if (q.shape == QUADRIC_CONE)
+    {
+        float slope = q.radius / q.height;
+        k[lane] = slope * slope;
+        rr[lane] = 0;
+    }
+    else
+    {
+        k[lane] = 0;
+        rr[lane] = q.radius * q.radius;
+    }
+}
+
+//Whether this processor runs intersectQuadrics()
+bool quadricKernelAvailable()
+{
+#ifdef QUADRIC_AVX2
+    static bool available = __builtin_cpu_supports("avx2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+#ifdef QUADRIC_AVX2
+//---Tests a ray against every lane of a pack --------------------------------------
+//   t[lane] is what the lane's object's intersect() returns.  Every lane is
+//     worked out in both forms and the wrong one dropped.  No FMA: fused
+//     products would round differently from the objects' own code.
+//----------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+void intersectQuadrics(const QuadricPack& pack, glm::vec3 p0, glm::vec3 dir, float t[QUADRIC_LANES])
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 negate = _mm256_set1_ps(-0.0f);
+    const __m256 miss = _mm256_set1_ps(-1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f), four = _mm256_set1_ps(4.0f);
+    __m256 px = _mm256_set1_ps(p0.x), py = _mm256_set1_ps(p0.y), pz = _mm256_set1_ps(p0.z);
+    __m256 dx = _mm256_set1_ps(dir.x), dy = _mm256_set1_ps(dir.y), dz = _mm256_set1_ps(dir.z);
+
+    __m256 cx = _mm256_load_ps(pack.cx), cy = _mm256_load_ps(pack.cy), cz = _mm256_load_ps(pack.cz);
+    __m256 rr = _mm256_load_ps(pack.rr), k = _mm256_load_ps(pack.k);
+    __m256 height = _mm256_load_ps(pack.height), top = _mm256_add_ps(height, cy);
+    __m256i shape = _mm256_load_si256((const __m256i*)pack.shape);
+    __m256 sphere = _mm256_castsi256_ps(_mm256_cmpeq_epi32(shape, _mm256_set1_epi32(QUADRIC_SPHERE)));
+    __m256 cone = _mm256_castsi256_ps(_mm256_cmpeq_epi32(shape, _mm256_set1_epi32(QUADRIC_CONE)));
+    __m256 cap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(shape, _mm256_set1_epi32(QUADRIC_CAPPED_CYLINDER)));
+
+    //Sphere::intersect(): b = dir.(p0-c), c = |p0-c|^2 - r^2, delta = b^2 - c
+    __m256 vx = _mm256_sub_ps(px, cx), vy = _mm256_sub_ps(py, cy), vz = _mm256_sub_ps(pz, cz);
+    __m256 sb = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, vx), _mm256_mul_ps(dy, vy)), _mm256_mul_ps(dz, vz));
+    __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)),
+                                              _mm256_mul_ps(vz, vz)));
+    __m256 sdelta = _mm256_sub_ps(_mm256_mul_ps(sb, sb), _mm256_sub_ps(_mm256_mul_ps(len, len), rr));
+
+    //Cylinder::intersect() and Cone::intersect(): a t^2 + b t + c, delta = b^2 - 4ac
+    __m256 xd = _mm256_sub_ps(px, cx), zd = _mm256_sub_ps(pz, cz);
+    __m256 yd = _mm256_add_ps(_mm256_sub_ps(height, py), cy);
+    __m256 kdy = _mm256_mul_ps(k, dy);
+    __m256 a = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz)), _mm256_mul_ps(kdy, dy));
+    __m256 b = _mm256_mul_ps(two, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, xd), _mm256_mul_ps(dz, zd)),
+                                                _mm256_mul_ps(kdy, yd)));
+    __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(xd, xd), _mm256_mul_ps(zd, zd)),
+                             _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(k, yd), yd), rr));
+    __m256 adelta = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_mul_ps(four, a), c));
+
+    __m256 delta = _mm256_blendv_ps(adelta, sdelta, sphere);
+    __m256 missed = _mm256_cmp_ps(delta, _mm256_set1_ps(0.001f), _CMP_LT_OQ);
+    if (_mm256_movemask_ps(missed) == 0xff)             //Most packs a ray reaches
+    {
+        _mm256_storeu_ps(t, miss);
+        return;
+    }
+    __m256 root = _mm256_sqrt_ps(delta);
+    __m256 negb = _mm256_xor_ps(_mm256_blendv_ps(b, sb, sphere), negate);
+    __m256 t1 = _mm256_sub_ps(negb, root), t2 = _mm256_add_ps(negb, root);
+    __m256 twoA = _mm256_mul_ps(two, a);
+    t1 = _mm256_blendv_ps(_mm256_div_ps(t1, twoA), t1, sphere);
+    t2 = _mm256_blendv_ps(_mm256_div_ps(t2, twoA), t2, sphere);
+
+    //Nearest root in front of p0, or -1, and the other one
+    __m256 t1Behind = _mm256_cmp_ps(t1, zero, _CMP_LT_OQ);
+    __m256 t2Ahead = _mm256_cmp_ps(t2, zero, _CMP_GT_OQ);
+    __m256 close = _mm256_blendv_ps(t1, _mm256_blendv_ps(miss, t2, t2Ahead), t1Behind);
+    __m256 far = _mm256_blendv_ps(t2, t1, t1Behind);
+
+    //Clipping to the base and the top
+    __m256 closeY = _mm256_add_ps(py, _mm256_mul_ps(close, dy));
+    __m256 below = _mm256_cmp_ps(closeY, cy, _CMP_LT_OQ);
+    __m256 above = _mm256_cmp_ps(closeY, top, _CMP_GT_OQ);
+    __m256 coneT = _mm256_blendv_ps(close, miss, _mm256_or_ps(below, above));
+
+    __m256 farY = _mm256_add_ps(py, _mm256_mul_ps(far, dy));
+    __m256 farOnWall = _mm256_and_ps(_mm256_cmp_ps(far, zero, _CMP_GT_OQ),
+                                     _mm256_and_ps(_mm256_cmp_ps(farY, cy, _CMP_GE_OQ), _mm256_cmp_ps(farY, top, _CMP_LE_OQ)));
+    __m256 belowT = _mm256_blendv_ps(miss, far, farOnWall);
+    __m256 capT = _mm256_div_ps(_mm256_sub_ps(top, py), dy);
+    __m256 aboveT = _mm256_blendv_ps(_mm256_blendv_ps(far, capT, cap), miss, _mm256_cmp_ps(farY, top, _CMP_GT_OQ));
+    __m256 cylinderT = _mm256_blendv_ps(_mm256_blendv_ps(close, aboveT, above), belowT, below);
+
+    __m256 result = _mm256_blendv_ps(_mm256_blendv_ps(cylinderT, coneT, cone), close, sphere);
+    _mm256_storeu_ps(t, _mm256_blendv_ps(result, miss, missed));
+}
+#else
+void intersectQuadrics(const QuadricPack& pack, glm::vec3 p0, glm::vec3 dir, float t[QUADRIC_LANES])
+{
+    for (int lane = 0; lane < QUADRIC_LANES; lane++) t[lane] = -1;     //Never called: quadricKernelAvailable() is false
+}
+#endif
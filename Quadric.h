@@ -0,0 +1,57 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Quadrics
+*  The analytic objects in one form, so that one ray can be
+*  tested against several of them at once.  Cylinders and
+*  cones are the quadric
+*      (x-cx)^2 + (z-cz)^2 - k (cy+h-y)^2 - rr = 0
+*  about a vertical axis (k = 0 for a cylinder of radius^2
+*  rr; rr = 0 for a cone, k its (radius/height)^2), clipped
+*  to cy <= y <= cy+h with a cylinder's optional top cap.
+*  Spheres keep their own form.  intersectQuadrics() tests
+*  a QuadricPack of up to QUADRIC_LANES of them with AVX2,
+*  doing the same arithmetic in the same order as each
+*  object's intersect(), so the results are the same to
+*  the bit.
+-------------------------------------------------------------*/
+
+#ifndef H_QUADRIC
+#define H_QUADRIC
+#include <glm/glm.hpp>
+#include <cstdint>
+
+const int QUADRIC_LANES = 8;
+
+enum QuadricShape
+{
+    QUADRIC_SPHERE,
+    QUADRIC_CYLINDER,
+    QUADRIC_CONE,
+    QUADRIC_CAPPED_CYLINDER     //Only in packs: a cylinder with cap set
+};
+
+struct Quadric
+{
+    QuadricShape shape;
+    glm::vec3 centre;       //Of a sphere; of the base of a cylinder or cone
+    float radius;
+    float height;           //Cylinders and cones
+    bool cap;               //Cylinder closed at the top
+};
+
+//QUADRIC_LANES quadrics, one per lane; unused lanes are cleared, and miss every ray
+struct alignas(32) QuadricPack
+{
+    float cx[QUADRIC_LANES], cy[QUADRIC_LANES], cz[QUADRIC_LANES];
+    float rr[QUADRIC_LANES], k[QUADRIC_LANES], height[QUADRIC_LANES];
+    int32_t shape[QUADRIC_LANES];
+
+    void clear();
+    void set(int lane, const Quadric& q);
+};
+
+bool quadricKernelAvailable();
+void intersectQuadrics(const QuadricPack& pack, glm::vec3 p0, glm::vec3 dir, float t[QUADRIC_LANES]);
+
+#endif //!H_QUADRIC
@@ -0,0 +1,245 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The primary raster class
+-------------------------------------------------------------*/
+
+#include "Raster.h"
+#include "Plane.h"
+#include <math.h>
+#include <algorithm>
+
+const float MIN_DEPTH = 1.e-3f;     //Boxes reaching closer to the eye plane than this go in every bin
+
+RasterCache::RasterCache()
+{
+    std::fill(bin, bin + RASTER_CACHE_BINS, -1);
+}
+
+/**
+* Projects p onto the image plane.  cell is in cell units from the bottom-left
+* corner and depth is the distance in front of the eye.  Returns false if p
+* is not in front of the eye.
+*/
+bool PrimaryRaster::project(glm::vec3 p, glm::vec2& cell, float& depth)
+{
+    glm::vec3 v = p - eye_;
+    depth = glm::dot(v, forward_);
+    if (depth < MIN_DEPTH) return false;
+    float s = edist_ / depth;
+    cell = glm::vec2((s * glm::dot(v, right_) - xmin_) / cellX_, (s * glm::dot(v, up_) - ymin_) / cellY_);
+    return true;
+}
+
+//---Bins the objects for primary rays of the given view ----------------------------
+//   An object goes in every bin its projected bounding box touches, widened by one
+//     cell to cover rounding.  Objects entirely behind the eye are left out, as
+//     primary rays cannot reach them, and those reaching behind it go in every bin.
+//----------------------------------------------------------------------------------
+void PrimaryRaster::build(std::vector<SceneObject*>& objects, Camera camera, float planeWidth, float planeHeight,
+                          float edist, int resolution)
+{
+    objects_ = &objects;
+    eye_ = camera.eye;
+    right_ = camera.right();
+    up_ = camera.up();
+    forward_ = camera.forward();
+    edist_ = edist;
+    xmin_ = -planeWidth * 0.5f;
+    ymin_ = -planeHeight * 0.5f;
+    cellX_ = planeWidth / resolution;
+    cellY_ = planeHeight / resolution;
+    resolution_ = resolution;
+    bins_ = (resolution + RASTER_BIN - 1) / RASTER_BIN;
+
+    struct Span { int b0x, b0y, b1x, b1y; };        //Bins covered, inclusive
+    std::vector<Span> spans(objects.size());
+    std::vector<float> nears(objects.size());
+    std::vector<int> counts(bins_ * bins_ + 1, 0);
+    everywhere_.clear();
+
+    for (size_t k = 0; k < objects.size(); k++)
+    {
+        glm::vec3 lo, hi;
+        objects[k]->bounds(lo, hi);
+        glm::vec3 closest = glm::clamp(eye_, lo, hi);
+        float near = glm::length(closest - eye_) * (1 - 1.e-4f) - 0.01f;   //Less the ray's start step, with margin
+        nears[k] = near;
+        spans[k] = {1, 1, 0, 0};
+
+        glm::vec2 cmin(1.e+30f), cmax(-1.e+30f);
+        int behind = 0, inFront = 0;
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec3 corner((c & 1) ? hi.x : lo.x, (c & 2) ? hi.y : lo.y, (c & 4) ? hi.z : lo.z);
+            glm::vec2 cell;
+            float depth;
+            if (project(corner, cell, depth))
+            {
+                inFront++;
+                cmin = glm::min(cmin, cell);
+                cmax = glm::max(cmax, cell);
+            }
+            else if (depth <= 0) behind++;
+        }
+        if (behind == 8) continue;
+        if (inFront < 8)
+        {
+            everywhere_.push_back({near, (int)k});
+            continue;
+        }
+
+        int x0 = std::max((int)floorf(cmin.x) - 1, 0), y0 = std::max((int)floorf(cmin.y) - 1, 0);
+        int x1 = std::min((int)floorf(cmax.x) + 1, resolution - 1), y1 = std::min((int)floorf(cmax.y) + 1, resolution - 1);
+        if (x0 > x1 || y0 > y1) continue;       //Off the screen
+        spans[k] = {x0 / RASTER_BIN, y0 / RASTER_BIN, x1 / RASTER_BIN, y1 / RASTER_BIN};
+        for (int by = spans[k].b0y; by <= spans[k].b1y; by++)
+            for (int bx = spans[k].b0x; bx <= spans[k].b1x; bx++)
+                counts[by * bins_ + bx + 1]++;
+    }
+
+    binStart_.assign(bins_ * bins_ + 1, 0);
+    for (int b = 0; b < bins_ * bins_; b++) binStart_[b + 1] = binStart_[b] + counts[b + 1];
+    candidates_.resize(binStart_.back());
+    std::vector<int> fill(binStart_.begin(), binStart_.end() - 1);
+    for (size_t k = 0; k < objects.size(); k++)
+        for (int by = spans[k].b0y; by <= spans[k].b1y; by++)
+            for (int bx = spans[k].b0x; bx <= spans[k].b1x; bx++)
+                candidates_[fill[by * bins_ + bx]++] = {nears[k], (int)k};
+
+    auto nearer = [](const Candidate& a, const Candidate& b) { return a.near < b.near; };
+    for (int b = 0; b < bins_ * bins_; b++)
+        std::sort(candidates_.begin() + binStart_[b], candidates_.begin() + binStart_[b + 1], nearer);
+    std::sort(everywhere_.begin(), everywhere_.end(), nearer);
+}
+
+//---Fills the z-buffer of a bin: the object to test first at each cell ---------------
+//   Planes and triangles are rasterized at the cell centres, interpolating 1/depth
+//     across each triangle; other objects cover their screen-space bounding box at
+//     the distance of their bounds.  The nearest wins.
+//----------------------------------------------------------------------------------
+void PrimaryRaster::rasterBin(int bin, int nearest[])
+{
+    const int n = RASTER_BIN * RASTER_BIN;
+    float zbuffer[n];
+    std::fill(zbuffer, zbuffer + n, 1.e+30f);
+    std::fill(nearest, nearest + n, -1);
+    int bx0 = (bin % bins_) * RASTER_BIN;
+    int by0 = (bin / bins_) * RASTER_BIN;
+    std::vector<SceneObject*>& objects = *objects_;
+
+    for (int e = binStart_[bin]; e < binStart_[bin + 1]; e++)
+    {
+        Candidate& cand = candidates_[e];
+        Plane* plane = dynamic_cast<Plane*>(objects[cand.index]);
+        if (plane == nullptr)
+        {
+            glm::vec3 lo, hi;
+            objects[cand.index]->bounds(lo, hi);
+            glm::vec2 cmin(1.e+30f), cmax(-1.e+30f), cell;
+            float depth;
+            for (int c = 0; c < 8; c++)
+            {
+                project(glm::vec3((c & 1) ? hi.x : lo.x, (c & 2) ? hi.y : lo.y, (c & 4) ? hi.z : lo.z), cell, depth);
+                cmin = glm::min(cmin, cell);
+                cmax = glm::max(cmax, cell);
+            }
+            for (int j = 0; j < RASTER_BIN; j++)
+                for (int i = 0; i < RASTER_BIN; i++)
+                {
+                    float cx = bx0 + i + 0.5f, cy = by0 + j + 0.5f;
+                    if (cx < cmin.x || cx > cmax.x || cy < cmin.y || cy > cmax.y) continue;
+                    if (cand.near < zbuffer[j * RASTER_BIN + i])
+                    {
+                        zbuffer[j * RASTER_BIN + i] = cand.near;
+                        nearest[j * RASTER_BIN + i] = cand.index;
+                    }
+                }
+            continue;
+        }
+
+        glm::vec2 v[4];
+        float w[4];         //1/depth of each vertex
+        for (int k = 0; k < plane->getNumVerts(); k++)
+        {
+            float depth;
+            project(plane->getVertex(k), v[k], depth);
+            w[k] = 1 / depth;
+        }
+        for (int tri = 0; tri < plane->getNumVerts() - 2; tri++)
+        {
+            int ia = 0, ib = tri + 1, ic = tri + 2;     //Fan of (a, b, c) and (a, c, d)
+            float area = (v[ib].x - v[ia].x) * (v[ic].y - v[ia].y) - (v[ib].y - v[ia].y) * (v[ic].x - v[ia].x);
+            if (fabsf(area) < 1.e-12f) continue;
+            for (int j = 0; j < RASTER_BIN; j++)
+                for (int i = 0; i < RASTER_BIN; i++)
+                {
+                    glm::vec2 p(bx0 + i + 0.5f, by0 + j + 0.5f);
+                    float la = ((v[ib].x - p.x) * (v[ic].y - p.y) - (v[ib].y - p.y) * (v[ic].x - p.x)) / area;
+                    float lb = ((v[ic].x - p.x) * (v[ia].y - p.y) - (v[ic].y - p.y) * (v[ia].x - p.x)) / area;
+                    float lc = 1 - la - lb;
+                    if (la < 0 || lb < 0 || lc < 0) continue;
+
+                    //Distance along the ray through the cell centre
+                    float depth = 1 / (la * w[ia] + lb * w[ib] + lc * w[ic]);
+                    float x = xmin_ + p.x * cellX_, y = ymin_ + p.y * cellY_;
+                    float dist = depth * sqrtf(x * x + y * y + edist_ * edist_) / edist_;
+                    if (dist < zbuffer[j * RASTER_BIN + i])
+                    {
+                        zbuffer[j * RASTER_BIN + i] = dist;
+                        nearest[j * RASTER_BIN + i] = cand.index;
+                    }
+                }
+        }
+    }
+}
+
+//---Finds the closest hit of a primary ray closer than maxDist ----------------------
+//   Same result as Scene::closestPt().  The object in the z-buffer is tested first;
+//     then the objects of the ray's bin and those in every bin, nearest first, until
+//     the rest lie beyond the closest hit.  Returns the number of objects tested, or
+//     -1 (without testing any) if the ray does not pass through the image plane.
+//----------------------------------------------------------------------------------
+int PrimaryRaster::closestPt(Ray& ray, float maxDist, RasterCache& cache)
+{
+    float ahead = glm::dot(ray.dir, forward_);
+    if (ahead <= 0) return -1;
+    float s = edist_ / ahead;
+    float cx = (s * glm::dot(ray.dir, right_) - xmin_) / cellX_;
+    float cy = (s * glm::dot(ray.dir, up_) - ymin_) / cellY_;
+    if (!(cx > -1 && cy > -1 && cx < resolution_ + 1 && cy < resolution_ + 1)) return -1;
+    int i = std::min(std::max((int)floorf(cx), 0), resolution_ - 1);    //Bins reach a cell beyond every object
+    int j = std::min(std::max((int)floorf(cy), 0), resolution_ - 1);
+
+    int bin = (j / RASTER_BIN) * bins_ + i / RASTER_BIN;
+    int slot = bin % RASTER_CACHE_BINS;
+    if (cache.bin[slot] != bin)
+    {
+        rasterBin(bin, cache.nearest[slot]);
+        cache.bin[slot] = bin;
+    }
+    int first = cache.nearest[slot][(j % RASTER_BIN) * RASTER_BIN + i % RASTER_BIN];
+
+    std::vector<SceneObject*>& objects = *objects_;
+    float tmin = maxDist;
+    int tests = 0;
+    auto test = [&](int k)
+    {
+        tests++;
+        float t = objects[k]->intersect(ray.p0, ray.dir);
+        if (t > 0 && (t < tmin || (t == tmin && k < ray.index)))
+        {
+            ray.hit = ray.p0 + ray.dir * t;
+            ray.index = k;
+            ray.dist = t;
+            tmin = t;
+        }
+    };
+
+    if (first >= 0) test(first);
+    for (int e = binStart_[bin]; e < binStart_[bin + 1] && candidates_[e].near <= tmin; e++)
+        if (candidates_[e].index != first) test(candidates_[e].index);
+    for (size_t e = 0; e < everywhere_.size() && everywhere_[e].near <= tmin; e++)
+        test(everywhere_[e].index);
+    return tests;
+}
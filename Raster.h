@@ -0,0 +1,71 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The primary raster class
+*  Finds the first hits of primary rays, which all start at
+*  the eye, from a rasterization of the objects instead of
+*  a search of the scene.  Every object is binned by the
+*  screen-space box its bounds project to, so a ray only
+*  meets the objects of its bin, nearest first, and stops
+*  once the rest lie behind its hit.  Within a bin, planes
+*  and triangles are rasterized into a z-buffer of the
+*  object nearest each cell's centre, which is tested
+*  first; other objects write their bounded screen-space
+*  quad.  The hit itself always comes from the objects'
+*  intersect(), so results are exactly those of
+*  Scene::closestPt().
+-------------------------------------------------------------*/
+
+#ifndef H_RASTER
+#define H_RASTER
+#include <glm/glm.hpp>
+#include <vector>
+#include "SceneObject.h"
+#include "Camera.h"
+#include "Ray.h"
+
+const int RASTER_BIN = 8;           //Cells along each side of a bin
+const int RASTER_CACHE_BINS = 64;   //Bins whose z-buffer a RasterCache keeps
+
+/**
+ * Z-buffers of the bins a thread used most recently, indexed by bin number
+ * modulo RASTER_CACHE_BINS.  Used by one thread.
+ */
+struct RasterCache
+{
+    int bin[RASTER_CACHE_BINS];                             //Bin held by each slot; -1 if empty
+    int nearest[RASTER_CACHE_BINS][RASTER_BIN * RASTER_BIN];    //Object to test first, or -1
+
+    RasterCache();
+};
+
+class PrimaryRaster
+{
+private:
+    struct Candidate
+    {
+        float near;         //Lower bound of the distance along any primary ray to a hit
+        int index;
+    };
+
+    std::vector<SceneObject*>* objects_ = nullptr;
+    glm::vec3 eye_, right_, up_, forward_;
+    float edist_ = 0;
+    float xmin_ = 0, ymin_ = 0;         //Bottom-left corner of the image plane
+    float cellX_ = 0, cellY_ = 0;
+    int resolution_ = 0;
+    int bins_ = 0;                      //Bins along each side of the image
+    std::vector<int> binStart_;         //Candidates of bin b are [binStart_[b], binStart_[b+1])
+    std::vector<Candidate> candidates_; //Nearest first within each bin
+    std::vector<Candidate> everywhere_; //Objects reaching behind the eye, in every bin
+
+    bool project(glm::vec3 p, glm::vec2& cell, float& depth);
+    void rasterBin(int bin, int nearest[]);
+
+public:
+    void build(std::vector<SceneObject*>& objects, Camera camera, float planeWidth, float planeHeight,
+               float edist, int resolution);
+    int closestPt(Ray& ray, float maxDist, RasterCache& cache);
+};
+
+#endif //!H_RASTER
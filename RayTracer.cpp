@@ -8,14 +8,12 @@
 */
 #include <cmath>
 #include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
 #include <glm/glm.hpp>
-#include "Sphere.h"
-#include "SceneObject.h"
-#include "Plane.h"
-#include "Cylinder.h"
-#include "Ray.h"
-#include "Cone.h"
-#include "TextureBMP.h"
+#include "Renderer.h"
 #include <GL/freeglut.h>
 
 
@@ -23,14 +21,7 @@ using namespace std;
 
 const float WIDTH = 100.0;
 const float HEIGHT = 100.0;
-const float EDIST = 100.0;
 const int NUMDIV = 600;
-const int MAX_STEPS = 5;
-const float MAX_FOG = -200;
-const float MIN_FOG = -20;
-
-const int MAX_ALIAS_STEPS = 5;
-const float COL_DIFF = 0.2f;
 
 const float XMIN = -WIDTH * 0.5;
 const float XMAX =  WIDTH * 0.5;
@@ -38,201 +29,173 @@ const float YMIN = -HEIGHT * 0.5;
 const float YMAX =  HEIGHT * 0.5;
 const int ANTI_ALIASING = true;
 const int FOG = true;
+const int PREVIEW_SCALE = 1;      //1 = full quality; 2 or 4 traces NUMDIV/PREVIEW_SCALE cells and upsamples
 
-TextureBMP texture;
+const float TARGET_FPS = 15;      //Frame rate aimed for while the camera moves
+const int MIN_MOVE_DIV = 25;      //Coarsest resolution used while the camera moves
+const float MOVE_STEP = 2;        //Distance moved per key press
+const float TURN_STEP = 3;        //Degrees turned per key press
+const float MOUSE_TURN = 0.3;     //Degrees turned per pixel of mouse drag
 
-vector<SceneObject*> sceneObjects;
+shared_ptr<Scene> scene;
 
 
-//---The most important function in a ray tracer! ---------------------------------- 
-//   Computes the colour value obtained by tracing a ray and finding its 
-//     closest point of intersection with objects in the scene.
-//----------------------------------------------------------------------------------
-glm::vec3 trace(Ray ray, int step)
+//---Render settings for a frame of div x div cells ----------------------------------------
+// Only the final frame at NUMDIV is anti-aliased (or previewed); motion frames never
+// are, even at NUMDIV.
+//---------------------------------------------------------------------------------------
+RenderSettings frameSettings(int div, bool motion = false)
 {
-	glm::vec3 backgroundCol(0.8, 0.8, 0.8);
-	glm::vec3 lightPos(30, 40, 20);					//Light's position
-	glm::vec3 color(0);
-	SceneObject* obj;
-
-    ray.closestPt(sceneObjects);					//Compare the ray with all objects in the scene
-    if(ray.index == -1) return backgroundCol;		//no intersection
-	obj = sceneObjects[ray.index];					//object on which the closest point of intersection is found
-
-
-	if (ray.index == 0)
-    {
-	    // Checker pattern
-	    int stripeWidth = 5;
-	    int iz = (ray.hit.z) / stripeWidth;
-        int ix = (ray.hit.x) / stripeWidth;
-
-	    int k = abs(iz % 2);
-        int l = abs(ix % 2);
-
-        if (ray.hit.x < 0) l = abs((ix + 1) % 2);
-
-        glm::vec3 floor_color(0);
-	    if (k == 0 && l == 0) floor_color = glm::vec3(1, 0, 0);
-	    else if (k == 0 && l == 1) floor_color = glm::vec3(0, 1, 0);
-	    else if (k == 1 && l == 0) floor_color = glm::vec3(0, 1, 0);
-        else if (k == 1 && l == 1) floor_color = glm::vec3(1, 0, 0);
-
-        obj->setColor(floor_color);
-    }
-
-	if (ray.index == 1) {
-
-	    glm::vec3 n = obj->normal(ray.hit);
+    RenderSettings settings;
+    settings.resolution = div;
+    settings.planeWidth = WIDTH;
+    settings.planeHeight = HEIGHT;
+    settings.fog = FOG;
+    settings.antiAliasing = (div == NUMDIV && !motion) && ANTI_ALIASING;
+    settings.previewScale = (div == NUMDIV && !motion) ? PREVIEW_SCALE : 1;
+    return settings;
+}
 
-	    float u = 0.5 + atan2(n.x, n.z)/(2*M_PI);
-	    float v = 0.5 - asin(n.y)/M_PI;
+//---Interactive rendering ----------------------------------------------------------------
+// While the camera moves, each change is drawn straight away at moveDiv x moveDiv
+// cells without anti-aliasing; moveDiv is adjusted after every such frame to hold
+// TARGET_FPS.  Once the camera stops, the view is refined on a background render
+// in levels that double the resolution up to the final NUMDIV frame with
+// anti-aliasing.  Any camera change cancels the level in progress.
+//---------------------------------------------------------------------------------------
+Camera camera;
+int cameraMoved = true;              //Set by input; cleared once a motion frame is drawn
+int moveDiv = NUMDIV / 4;            //Resolution of motion frames
 
-	    glm::vec3 texture_colour = texture.getColorAt(u, v);
-	    obj->setColor(texture_colour);
-	}
+Image displayImage;                  //Most recently completed image
 
-    glm::vec3 surface_color = obj->lighting(lightPos, -ray.dir, ray.hit);
-    glm::vec3 lightVec = lightPos - ray.hit;
+thread refiner;                      //Background render of the current refinement level
+int refining = false;
+atomic<bool> cancelRefinement(false);
+atomic<bool> refinementDone(false);
+Image refinedImage;
 
-    Ray shadowRay(ray.hit, lightVec);
-    shadowRay.closestPt(sceneObjects);
+void startLevel(int div)
+{
+    RenderSettings settings = frameSettings(div);
+    settings.cancel = &cancelRefinement;
+    cancelRefinement = false;
+    refinementDone = false;
+    refining = true;
+    Camera view = camera;
+    refiner = thread([settings, view]()
+    {
+        refinedImage = render(*scene, view, settings);
+        refinementDone = true;
+    });
+}
 
-    if(shadowRay.index > -1 && shadowRay.dist < glm::length(lightVec)) {
+void stopRefinement()
+{
+    if (!refining) return;
+    cancelRefinement = true;
+    refiner.join();
+    refining = false;
+}
 
-        SceneObject* shadowHitObj = sceneObjects[shadowRay.index];
+//Renders a whole frame at moveDiv and adapts moveDiv to the time it took
+void renderMotionFrame()
+{
+    auto start = chrono::steady_clock::now();
+    displayImage = render(*scene, camera, frameSettings(moveDiv, true));
+    glutPostRedisplay();
+
+    double frameTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    int div = moveDiv * sqrt((1.0 / TARGET_FPS) / fmax(frameTime, 1.e-4));
+    int shown = displayImage.getWidth();
+    moveDiv = glm::clamp(div, MIN_MOVE_DIV, NUMDIV);
+
+    cameraMoved = false;
+    if (shown < NUMDIV) startLevel(min(shown * 2, NUMDIV));
+    else if (ANTI_ALIASING) startLevel(NUMDIV);     //Only anti-aliasing is left to add
+    else glutIdleFunc(nullptr);
+}
 
-        if (shadowHitObj->isTransparent())
-        {
-            surface_color = 0.2f * shadowHitObj->getColor() * (1-shadowHitObj->getTransparencyCoeff()) + ((shadowHitObj->getTransparencyCoeff()) * surface_color);
-        }
-        else if (shadowHitObj->isRefractive())
-        {
-            surface_color = 0.8f * (shadowHitObj->getColor() * (1-shadowHitObj->getRefractionCoeff()) + ((shadowHitObj->getRefractionCoeff()) * surface_color));
-        }
-        else {
-            surface_color = 0.1f * obj->getColor();
-        }
+void idle()
+{
+    if (cameraMoved)
+    {
+        stopRefinement();
+        renderMotionFrame();
     }
-
-	if(obj->isReflective() && step < MAX_STEPS)
-	{
-	    float rho = obj->getReflectionCoeff();
-	    glm::vec3 normalVec = obj->normal(ray.hit);
-	    glm::vec3 reflectedDir = glm::reflect(ray.dir, normalVec);
-	    Ray reflectedRay(ray.hit, reflectedDir);
-	    glm::vec3 reflectedColor = trace(reflectedRay, step + 1);
-	    surface_color = (1-rho)*surface_color + (rho * reflectedColor);
-	}
-
-	if(obj->isRefractive() && step < MAX_STEPS)
-	{
-	    float rho = obj->getRefractionCoeff();
-	    float eta = obj->getRefractiveIndex();
-
-	    // Initial Hit
-	    glm::vec3 normalVec = obj->normal(ray.hit);
-	    glm::vec3 refractedDir = glm::refract(ray.dir, normalVec, eta);
-	    Ray refractedRay(ray.hit, refractedDir);
-	    refractedRay.closestPt(sceneObjects);
-
-	    // Inside Sphere
-	    glm::vec3 refNormalVec = obj->normal(refractedRay.hit);
-	    glm::vec3 exitRayDir = glm::refract(refractedDir, -refNormalVec, 1.0f/eta);
-	    Ray exitRay(refractedRay.hit, exitRayDir);
-
-	    // Recurse for MAX_STEPS
-        glm::vec3 refractedColor = trace(exitRay, step + 1);
-        surface_color = (1-rho) * surface_color + (rho * refractedColor);
-	}
-
-	if(obj->isTransparent() && step < MAX_STEPS)
+    else if (refining && refinementDone)
     {
-	    float rho = obj->getTransparencyCoeff();
-	    Ray transparentRay(ray.hit, ray.dir);
-	    transparentRay.closestPt(sceneObjects);
-	    Ray exitRay(transparentRay.hit, ray.dir);
-        glm::vec3 transparentColor = trace(exitRay, step + 1);
-        surface_color = (1-rho)*surface_color + (rho * transparentColor);
+        refiner.join();
+        refining = false;
+        displayImage = refinedImage;
+        glutPostRedisplay();
+        int div = displayImage.getWidth();
+        if (div < NUMDIV) startLevel(min(div * 2, NUMDIV));
+        else glutIdleFunc(nullptr);      //Nothing left to do until the camera moves again
     }
+    else this_thread::sleep_for(chrono::milliseconds(5));
+}
 
+//Called after every camera change: requests a motion frame, which cancels refinement
+void moveCamera()
+{
+    cameraMoved = true;
+    glutIdleFunc(idle);
+}
 
-	if (FOG)
-    {
-        float fog = (ray.hit.z-MIN_FOG)/(MAX_FOG-MIN_FOG);
-        color += (1-fog)*surface_color + fog*glm::vec3(0.8, 0.8, 0.8);
-    }
-	else
+//---Keyboard and mouse camera controls --------------------------------------------------
+// w/s: forward/back, a/d: left/right, q/e: down/up, arrow keys or dragging
+// with the left mouse button: turn and tilt.
+//---------------------------------------------------------------------------------------
+void keyboard(unsigned char key, int x, int y)
+{
+    if (key != 'w' && key != 's' && key != 'a' && key != 'd' && key != 'q' && key != 'e') return;
+    stopRefinement();           //The background render reads the camera
+    switch (key)
     {
-	    color += surface_color;
+        case 'w': camera.move(MOVE_STEP, 0, 0); break;
+        case 's': camera.move(-MOVE_STEP, 0, 0); break;
+        case 'a': camera.move(0, -MOVE_STEP, 0); break;
+        case 'd': camera.move(0, MOVE_STEP, 0); break;
+        case 'q': camera.move(0, 0, -MOVE_STEP); break;
+        case 'e': camera.move(0, 0, MOVE_STEP); break;
     }
-
-
-    return color;
+    moveCamera();
 }
 
-int isDistinct(glm::vec3 color1, glm::vec3 ave) {
-    return (abs(color1.x - ave.x) > COL_DIFF) ||
-    (abs(color1.y - ave.y) > COL_DIFF) ||
-    (abs(color1.z - ave.z) > COL_DIFF);
+void special(int key, int x, int y)
+{
+    if (key != GLUT_KEY_LEFT && key != GLUT_KEY_RIGHT && key != GLUT_KEY_UP && key != GLUT_KEY_DOWN) return;
+    stopRefinement();
+    switch (key)
+    {
+        case GLUT_KEY_LEFT: camera.turn(TURN_STEP, 0); break;
+        case GLUT_KEY_RIGHT: camera.turn(-TURN_STEP, 0); break;
+        case GLUT_KEY_UP: camera.turn(0, TURN_STEP); break;
+        case GLUT_KEY_DOWN: camera.turn(0, -TURN_STEP); break;
+    }
+    moveCamera();
 }
 
+int mouseX = 0, mouseY = 0;
+int dragging = false;
 
-
-glm::vec3 aliasing(glm::vec3 eye, float xp, float yp, float cellX, float cellY, int step)
+void mouse(int button, int state, int x, int y)
 {
-    Ray ray;
-    glm::vec3 dir;
-
-    // Ray 1
-    dir = glm::vec3(xp+0.25*cellX, yp+0.25*cellY, -EDIST);
-    ray = Ray(eye, dir);
-    glm::vec3 col1 = trace(ray, 1);
-
-    // Ray 2
-    dir = glm::vec3(xp+0.75*cellX, yp+0.25*cellY, -EDIST);
-    ray = Ray(eye, dir);
-    glm::vec3 col2 = trace(ray, 1);
-
-    // Ray 3
-    dir = glm::vec3(xp+0.75*cellX, yp+0.25*cellY, -EDIST);
-    ray = Ray(eye, dir);
-    glm::vec3 col3 = trace(ray, 1);
-
-    // Ray 4
-    dir = glm::vec3(xp+0.75*cellX, yp+0.75*cellY, -EDIST);
-    ray = Ray(eye, dir);
-    glm::vec3 col4 = trace(ray, 1);
-
-
-    glm::vec3 ave = (col1 + col2 + col3 + col4) / 4.0f;
-
-    if (step >= MAX_ALIAS_STEPS) {
-        return ave;
-    } else {
-
-        if (isDistinct(col1, ave))
-        {
-            col1 = aliasing(eye, xp, yp, cellX*0.5f, cellY*0.5f, step+1);
-        }
-
-        if (isDistinct(col2, ave))
-        {
-            col2 = aliasing(eye, xp + 0.5f*cellX, yp, cellX*0.5f, cellY*0.5f, step+1);
-        }
-
-        if (isDistinct(col3, ave))
-        {
-            col3 = aliasing(eye, xp, yp + 0.5f*cellY, cellX*0.5f, cellY*0.5f, step+1);
-        }
-
-        if (isDistinct(col4, ave))
-        {
-            col4 = aliasing(eye, xp + 0.5f*cellX, yp + 0.5f*cellY, cellX*0.5f, cellY*0.5f, step+1);
-        }
+    if (button != GLUT_LEFT_BUTTON) return;
+    dragging = (state == GLUT_DOWN);
+    mouseX = x;
+    mouseY = y;
+}
 
-        return (col1 + col2 + col3 + col4) / 4.0f;
-    }
+void motion(int x, int y)
+{
+    if (!dragging) return;
+    stopRefinement();
+    camera.turn((mouseX - x) * MOUSE_TURN, (mouseY - y) * MOUSE_TURN);
+    mouseX = x;
+    mouseY = y;
+    moveCamera();
 }
 
 //---The main display module -----------------------------------------------------------
@@ -242,39 +205,23 @@ glm::vec3 aliasing(glm::vec3 eye, float xp, float yp, float cellX, float cellY,
 void display()
 {
 	float xp, yp;  //grid point
-	float cellX = (XMAX-XMIN)/NUMDIV;  //cell width
-	float cellY = (YMAX-YMIN)/NUMDIV;  //cell height
+	int div = displayImage.getWidth();
+	float cellX = (XMAX-XMIN)/div;  //cell width
+	float cellY = (YMAX-YMIN)/div;  //cell height
 
 	glClear(GL_COLOR_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
-    glm::vec3 eye(0., 0., 0.);
 
 	glBegin(GL_QUADS);  //Each cell is a tiny quad.
 
-	for(int i = 0; i < NUMDIV; i++)	//Scan every cell of the image plane
+	for(int i = 0; i < div; i++)
 	{
 		xp = XMIN + i*cellX;
-		for(int j = 0; j < NUMDIV; j++)
+		for(int j = 0; j < div; j++)
 		{
 			yp = YMIN + j*cellY;
-
-            glm::vec3 col;
-
-
-			if (ANTI_ALIASING) {
-
-                col = aliasing(eye, xp, yp, cellX, cellY, 1);
-
-			} else {
-
-
-                glm::vec3 dir(xp+0.5*cellX, yp+0.5*cellY, -EDIST);	//direction of the primary ray
-
-                Ray ray = Ray(eye, dir);
-
-                col = trace (ray, 1); //Trace the primary ray and get the colour value
-			}
+            glm::vec3 col = displayImage.at(i, j);
 
 			glColor3f(col.r, col.g, col.b);
 			glVertex2f(xp, yp);				//Draw each cell with its color value
@@ -290,8 +237,8 @@ void display()
 
 
 //---This function initializes the scene ------------------------------------------- 
-//   Specifically, it creates scene objects (spheres, planes, cones, cylinders etc)
-//     and add them to the list of scene objects.
+//   The scene itself (spheres, planes, cones, cylinders etc) is created by the
+//     renderer library; see createDefaultScene().
 //   It also initializes the OpenGL orthographc projection matrix for drawing the
 //     the ray traced image.
 //----------------------------------------------------------------------------------
@@ -302,96 +249,7 @@ void initialize()
 
     glClearColor(0, 0, 0, 1);
 
-    texture = TextureBMP("Butterfly.bmp");
-
-    Plane *plane = new Plane(glm::vec3(-200., -15, -30),
-                             glm::vec3(200., -15, -30),
-                             glm::vec3(200., -15, -200),
-                             glm::vec3(-200., -15, -200));
-
-
-    plane->setSpecularity(false);
-    sceneObjects.push_back(plane);
-
-    // Textured Sphere
-    Sphere *texturedSphere = new Sphere(glm::vec3(6, -4, -55), 3.0);
-    //texturedSphere->setShininess(5);
-    sceneObjects.push_back(texturedSphere);
-
-
-    glm::vec3 A(-10, -15, -45);
-    glm::vec3 B(0, -15, -35);
-    glm::vec3 C(0, -5, -37.5);
-    glm::vec3 D(10, -15, -45);
-    glm::vec3 E(0, -15, -55);
-
-
-    Plane *triangle1 = new Plane(A, B, C);
-    Plane *triangle2 = new Plane(B, D, C);
-    Plane *triangle3 = new Plane(D, E, C);
-    Plane *triangle4 = new Plane(E, A, C);
-
-
-    triangle1->setColor(glm::vec3(0, 0, 1));
-    triangle2->setColor(glm::vec3(0, 0, 1));
-    triangle3->setColor(glm::vec3(0, 0, 1));
-    triangle4->setColor(glm::vec3(0, 0, 1));
-    sceneObjects.push_back(triangle1);
-    sceneObjects.push_back(triangle2);
-    sceneObjects.push_back(triangle3);
-    sceneObjects.push_back(triangle4);
-
-
-    //Refractive Sphere
-	Sphere *sphere1 = new Sphere(glm::vec3(0, 0, -37), 5.0);
-	sphere1->setColor(glm::vec3(1, 1, 0));
-	sphere1->setRefractivity(true, 0.76, 1.01);
-	sphere1->setReflectivity(true, 0.2);
-
-    sphere1->setShininess(20);
-	sceneObjects.push_back(sphere1);		 //Add sphere to scene objects
-
-	//Red Sphere
-	Sphere *sphere2 = new Sphere(glm::vec3(5, 10, -100), 4.0);
-	sphere2->setColor(glm::vec3(1, 0, 0));
-	sphere2->setShininess(5);
-	sceneObjects.push_back(sphere2);
-
-	//Reflective Sphere
-    Sphere *sphere3 = new Sphere(glm::vec3(-5, 0, -60), 5.0);
-    sphere3->setColor(glm::vec3(0, 0, 0));
-    sphere3->setShininess(5);
-    sphere3->setReflectivity(true, 0.8);
-    sceneObjects.push_back(sphere3);
-
-    Sphere *sphere4 = new Sphere(glm::vec3(20, -5, -50), 4.25);
-    sphere4->setTransparency(true, 0.5);
-    sphere4->setColor(glm::vec3(0.4, 0.4, 0.8));
-    sphere4->setReflectivity(true, 0.2);
-    sceneObjects.push_back(sphere4);
-
-	Cylinder *cylinder1 = new Cylinder(glm::vec3(20, -15, -50), 2.5, 5, true);
-	cylinder1->setColor(glm::vec3(0, 0, 1));
-	sceneObjects.push_back(cylinder1);
-
-    Sphere *sphere6 = new Sphere(glm::vec3(-20, -5, -50), 4.25);
-    sphere6->setTransparency(true, 0.5);
-    sphere6->setColor(glm::vec3(0.4, 0.4, 0.8));
-    sphere6->setReflectivity(true, 0.2);
-    sceneObjects.push_back(sphere6);
-
-    Cylinder *cylinder2 = new Cylinder(glm::vec3(-20, -15, -50), 2.5, 5, true);
-    cylinder2->setColor(glm::vec3(0, 0, 1));
-    sceneObjects.push_back(cylinder2);
-
-    Cone *cone1 = new Cone(glm::vec3(40, -15, -100), 2, 10);
-    cone1->setColor(glm::vec3(1, 0, 0));
-    sceneObjects.push_back(cone1);
-
-    Cone *cone2 = new Cone(glm::vec3(-40, -15, -100), 2, 10);
-    cone2->setColor(glm::vec3(1, 0, 0));
-    sceneObjects.push_back(cone2);
-
+    scene = createDefaultScene();
 }
 
 int main(int argc, char *argv[]) {
@@ -402,6 +260,11 @@ int main(int argc, char *argv[]) {
     glutCreateWindow("Raytracing");
 
     glutDisplayFunc(display);
+    glutKeyboardFunc(keyboard);
+    glutSpecialFunc(special);
+    glutMouseFunc(mouse);
+    glutMotionFunc(motion);
+    glutIdleFunc(idle);
     initialize();
 
     glutMainLoop();
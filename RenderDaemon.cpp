@@ -0,0 +1,592 @@
+/*==================================================================================
+* COSC 363  Computer Graphics
+* Department of Computer Science and Software Engineering, University of Canterbury.
+*
+* Render daemon
+* A long-running render service on a Unix domain socket.  Scenes (with their
+* textures) are built once and kept in memory, so back-to-back renders of the same
+* scene with different cameras or settings skip all setup work.  Up to
+* MAX_ACTIVE_JOBS jobs render at once, taken from the queue highest priority
+* first, and the tiles of every running job share one thread pool, again
+* highest priority first.  Images are streamed to their file tile by tile, so
+* even very large renders need little memory.  A job given a checkpoint file
+* saves its finished tiles there; submitted again after the daemon is killed, it
+* renders only the tiles that are missing.  The file is removed once the image
+* is written.  A job given a shared memory name also writes its tiles into a
+* framebuffer there as they finish (see SharedFramebuffer.h), which viewers can
+* map and watch.  Scenes can be edited while they render: an edit publishes a
+* new version of the scene (see SceneVersions.h), jobs started later render it,
+* and jobs already running finish with the version they began with.
+*
+* Usage:  RenderDaemon.out [socket path] [threads]
+*
+* Protocol: one command per line, one reply line per command.
+*   RENDER <scene> [key=value ...]   -> OK <job id>
+*       keys: out=<file.ppm> priority=<int> res=<cells> aa=0|1 fog=0|1
+*             preview=1|2|4 steps=<max depth> eye=<x>,<y>,<z> yaw=<deg> pitch=<deg>
+*             cap=<rays per pixel> budget=<rays> deadline=<ms after submission>
+*             (at the deadline, tiles not yet traced are taken from a coarse preview)
+*             sampler=regular|stratified|halton|sobol|bluenoise penumbra=<shadow rays>
+*             raster=0|1 cull=0|1 heatmap=<file.ppm> cost=traces|tests|time timeline=<file.json>
+*             checkpoint=<file> checkpointevery=<seconds>  (not with budget or deadline)
+*             shm=<shared memory name, e.g. /frame> shmformat=rgb8|float
+*   EDIT <scene> [object=<index>] [key=value ...]   -> OK <scene version>
+*       keys: light=<x>,<y>,<z> background=<r>,<g>,<b>, and of the object
+*             color=<r>,<g>,<b> reflect=<coeff> transparent=<coeff> shininess=<s>
+*             (a coefficient of 0 turns the property off)
+*   STATUS <job id>                  -> QUEUED | RUNNING <tiles done>/<tiles> | DONE <ms>
+*                                       | CANCELLED | FAILED <reason>
+*   WAIT <job id>                    -> as STATUS, once the job has finished
+*   CANCEL <job id>                  -> OK
+*   STATS                            -> OK scenes=<n> jobs=<n> running=<n> threads=<n>
+*   QUIT                             -> closes the connection
+*   SHUTDOWN                         -> cancels all jobs, disconnects the clients and stops
+*                                       the daemon; later commands get ERROR
+*===================================================================================
+*/
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Renderer.h"
+#include "PPMWriter.h"
+#include "SceneVersions.h"
+#include "SharedFramebuffer.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+const char* DEFAULT_SOCKET = "/tmp/raytracer.sock";
+const int MAX_ACTIVE_JOBS = 4;          //Jobs rendering at the same time
+const int MAX_FINISHED_JOBS = 1000;     //Finished jobs kept for STATUS queries
+
+enum JobStatus { QUEUED, RUNNING, DONE, CANCELLED, FAILED };
+
+struct Job
+{
+    int id;
+    string sceneName;
+    string outPath;
+    string sharedName;                  //Shared framebuffer to render into as well, if wanted
+    FramebufferFormat sharedFormat = FB_RGB8;
+    string heatmapPath;                 //Cost heatmap of the render, if wanted
+    CostChannel heatmapCost = COST_NANOS;
+    string timelinePath;                //Chrome trace of the render's tiles, if wanted
+    Camera camera;
+    RenderSettings settings;
+    atomic<bool> cancel;
+    atomic<int> tilesDone;
+    atomic<int> tilesTotal;
+    JobStatus status = QUEUED;
+    string error;
+    double millis = 0;
+    chrono::steady_clock::time_point submitted = chrono::steady_clock::now();
+
+    Job() : cancel(false), tilesDone(0), tilesTotal(0) {}
+};
+
+//---Scenes built so far, by name -----------------------------------------------------
+//   Building a scene (objects, textures, ...) happens once; every later job
+//     shares the resident copy.  Scenes are only read while rendering; edits
+//     make new versions, and stay for as long as the daemon.
+//----------------------------------------------------------------------------------
+class SceneCache
+{
+private:
+    map<string, unique_ptr<SceneVersions>> scenes_;
+    mutex mutex_;
+
+public:
+    SceneVersions* get(const string& name)
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = scenes_.find(name);
+        if (it != scenes_.end()) return it->second.get();
+        shared_ptr<Scene> scene = loadScene(name);
+        if (scene == nullptr) return nullptr;
+        SceneVersions* versions = new SceneVersions(scene);
+        scenes_[name] = unique_ptr<SceneVersions>(versions);
+        return versions;
+    }
+
+    int size()
+    {
+        lock_guard<mutex> lock(mutex_);
+        return (int)scenes_.size();
+    }
+};
+
+ThreadPool* pool;           //Runs the tiles of all jobs
+ThreadPool* drivers;        //Runs the jobs themselves
+SceneCache sceneCache;
+
+map<int, shared_ptr<Job>> jobs;
+mutex jobsMutex;
+condition_variable jobFinished;
+int nextJobId = 1;
+atomic<bool> shuttingDown(false);
+int listenFd = -1;
+
+set<int> clientFds;         //Sockets of the connected clients, each served by its own thread
+mutex clientsMutex;
+condition_variable clientsDone;
+
+const char* statusName(JobStatus status)
+{
+    switch (status)
+    {
+        case QUEUED: return "QUEUED";
+        case RUNNING: return "RUNNING";
+        case DONE: return "DONE";
+        case CANCELLED: return "CANCELLED";
+        default: return "FAILED";
+    }
+}
+
+string statusLine(Job& job)
+{
+    ostringstream out;
+    out << statusName(job.status);
+    if (job.status == RUNNING) out << " " << job.tilesDone << "/" << job.tilesTotal;
+    if (job.status == DONE) out << " " << (long)job.millis;
+    if (job.status == FAILED) out << " " << job.error;
+    return out.str();
+}
+
+void finishJob(Job& job, JobStatus status)
+{
+    lock_guard<mutex> lock(jobsMutex);
+    job.status = status;
+    jobFinished.notify_all();
+}
+
+//Hands the tiles of a job to its outputs, a file and a shared framebuffer, each if wanted
+class JobSink : public TileSink
+{
+public:
+    PPMWriter* file = nullptr;
+    SharedFramebuffer* framebuffer = nullptr;
+
+    void write(Tile& tile, Image& pixels)
+    {
+        if (file != nullptr) file->write(tile, pixels);
+        if (framebuffer != nullptr) framebuffer->write(tile, pixels);
+    }
+};
+
+//Runs one job: looks up the scene and renders it on the shared pool into its file
+void runJob(shared_ptr<Job> job)
+{
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        if (job->cancel) { job->status = CANCELLED; jobFinished.notify_all(); return; }
+        job->status = RUNNING;
+    }
+    auto start = chrono::steady_clock::now();
+
+    //The deadline counts from submission, so time spent queued comes off it
+    if (job->settings.deadlineMs > 0)
+    {
+        double queued = chrono::duration<double, milli>(start - job->submitted).count();
+        job->settings.deadlineMs = max(1.0, job->settings.deadlineMs - queued);
+    }
+
+    SceneVersions* versions = sceneCache.get(job->sceneName);
+    if (versions == nullptr)
+    {
+        job->error = "unknown scene " + job->sceneName;
+        finishJob(*job, FAILED);
+        return;
+    }
+    SceneSnapshot snapshot = versions->pin();       //Edits from now on are for later jobs
+
+    int res = job->settings.resolution;
+    PPMWriter writer;
+    SharedFramebuffer framebuffer;
+    JobSink sink;
+    if (!job->outPath.empty())
+    {
+        if (!writer.open(job->outPath.c_str(), res, res))
+        {
+            job->error = "cannot write " + job->outPath;
+            finishJob(*job, FAILED);
+            return;
+        }
+        sink.file = &writer;
+    }
+    if (!job->sharedName.empty())
+    {
+        //Preview tiles hold whole blocks; round as the renderer would, so framebuffer tiles match
+        int scale = max(job->settings.previewScale, 1);
+        job->settings.tileSize = (job->settings.tileSize + scale - 1) / scale * scale;
+        if (!framebuffer.open(job->sharedName.c_str(), res, res, job->settings.tileSize, job->sharedFormat))
+        {
+            job->error = "cannot map " + job->sharedName;
+            finishJob(*job, FAILED);
+            return;
+        }
+        sink.framebuffer = &framebuffer;
+    }
+
+    Job* progressJob = job.get();       //Not the shared pointer: the job owns its settings
+    job->settings.progress = [progressJob](int done, int total)
+    {
+        progressJob->tilesDone = done;
+        progressJob->tilesTotal = total;
+    };
+    Image costs;
+    Timeline timeline;
+    if (!job->heatmapPath.empty())
+    {
+        costs = Image(job->settings.resolution, job->settings.resolution);
+        job->settings.costImage = &costs;
+    }
+    if (!job->timelinePath.empty()) job->settings.timeline = &timeline;
+
+    render(*snapshot.scene(), job->camera, job->settings, sink);
+    bool written = writer.close();
+    if (!job->cancel && !job->heatmapPath.empty() && !costHeatmap(costs, job->heatmapCost).writePPM(job->heatmapPath.c_str()))
+    {
+        job->error = "cannot write " + job->heatmapPath;
+        finishJob(*job, FAILED);
+        return;
+    }
+    if (!job->cancel && !job->timelinePath.empty() && !timeline.writeJSON(job->timelinePath.c_str()))
+    {
+        job->error = "cannot write " + job->timelinePath;
+        finishJob(*job, FAILED);
+        return;
+    }
+    if (job->cancel)
+    {
+        finishJob(*job, CANCELLED);
+        return;
+    }
+    if (!written)
+    {
+        job->error = "cannot write " + job->outPath;
+        finishJob(*job, FAILED);
+        return;
+    }
+    if (!job->settings.checkpoint.empty()) unlink(job->settings.checkpoint.c_str());    //The image is safe
+    job->millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "Job " << job->id << " (" << job->sceneName << " version " << snapshot.version() << ") done in " << (long)job->millis << " ms" << endl;
+    finishJob(*job, DONE);
+}
+
+int parseVec3(const string& text, glm::vec3& v)
+{
+    return sscanf(text.c_str(), "%f,%f,%f", &v.x, &v.y, &v.z) == 3;
+}
+
+//Forgets the oldest finished jobs once there are too many (jobsMutex must be held)
+void pruneJobs()
+{
+    int finished = 0;
+    for (auto& entry : jobs) if (entry.second->status > RUNNING) finished++;
+    for (auto it = jobs.begin(); it != jobs.end() && finished > MAX_FINISHED_JOBS; )
+    {
+        if (it->second->status > RUNNING)
+        {
+            it = jobs.erase(it);
+            finished--;
+        }
+        else ++it;
+    }
+}
+
+//Parses "RENDER <scene> key=value ..." into a new job; returns an error message or ""
+string parseRender(istringstream& in, Job& job)
+{
+    if (!(in >> job.sceneName)) return "missing scene name";
+
+    string item;
+    while (in >> item)
+    {
+        size_t eq = item.find('=');
+        if (eq == string::npos) return "expected key=value: " + item;
+        string key = item.substr(0, eq);
+        string value = item.substr(eq + 1);
+
+        if (key == "out") job.outPath = value;
+        else if (key == "priority") job.settings.priority = atoi(value.c_str());
+        else if (key == "res") job.settings.resolution = atoi(value.c_str());
+        else if (key == "aa") job.settings.antiAliasing = atoi(value.c_str());
+        else if (key == "fog") job.settings.fog = atoi(value.c_str());
+        else if (key == "preview") job.settings.previewScale = atoi(value.c_str());
+        else if (key == "steps") job.settings.maxSteps = atoi(value.c_str());
+        else if (key == "cap") job.settings.maxPixelSamples = atoi(value.c_str());
+        else if (key == "budget") job.settings.sampleBudget = atol(value.c_str());
+        else if (key == "deadline") job.settings.deadlineMs = atof(value.c_str());
+        else if (key == "penumbra") job.settings.penumbraSamples = atoi(value.c_str());
+        else if (key == "shm") job.sharedName = value;
+        else if (key == "shmformat")
+        {
+            if (value == "rgb8") job.sharedFormat = FB_RGB8;
+            else if (value == "float") job.sharedFormat = FB_RGB32F;
+            else return "unknown shmformat " + value;
+        }
+        else if (key == "checkpoint") job.settings.checkpoint = value;
+        else if (key == "checkpointevery") job.settings.checkpointSeconds = atof(value.c_str());
+        else if (key == "raster") job.settings.rasterPrimary = atoi(value.c_str());
+        else if (key == "cull") job.settings.cullTiles = atoi(value.c_str());
+        else if (key == "heatmap") job.heatmapPath = value;
+        else if (key == "timeline") job.timelinePath = value;
+        else if (key == "cost")
+        {
+            if (value == "traces") job.heatmapCost = COST_TRACES;
+            else if (value == "tests") job.heatmapCost = COST_TESTS;
+            else if (value == "time") job.heatmapCost = COST_NANOS;
+            else return "unknown cost " + value;
+        }
+        else if (key == "sampler")
+        {
+            int type = SAMPLER_REGULAR;
+            while (type <= SAMPLER_BLUE_NOISE && value != samplerName((SamplerType)type)) type++;
+            if (type > SAMPLER_BLUE_NOISE) return "unknown sampler " + value;
+            job.settings.sampler = (SamplerType)type;
+        }
+        else if (key == "yaw") job.camera.yaw = atof(value.c_str());
+        else if (key == "pitch") job.camera.pitch = atof(value.c_str());
+        else if (key == "eye") { if (!parseVec3(value, job.camera.eye)) return "bad eye: " + value; }
+        else return "unknown key: " + key;
+    }
+    if (job.settings.resolution <= 0) return "bad res";
+    if (job.settings.previewScale < 1) return "bad preview";
+    if (!job.settings.checkpoint.empty() && (job.settings.sampleBudget > 0 || job.settings.deadlineMs > 0))
+        return "checkpoint cannot be used with budget or deadline";   //Those renders refine cells, not tiles
+    return "";
+}
+
+//Parses "EDIT <scene> key=value ..." and publishes the edited scene; returns an error message or ""
+string editScene(istringstream& in, uint64_t& version)
+{
+    string name;
+    if (!(in >> name)) return "missing scene name";
+    SceneVersions* versions = sceneCache.get(name);
+    if (versions == nullptr) return "unknown scene " + name;
+
+    int object = -1;
+    vector<pair<string, string>> changes;
+    string item;
+    while (in >> item)
+    {
+        size_t eq = item.find('=');
+        if (eq == string::npos) return "expected key=value: " + item;
+        if (item.substr(0, eq) == "object") object = atoi(item.c_str() + eq + 1);
+        else changes.push_back(make_pair(item.substr(0, eq), item.substr(eq + 1)));
+    }
+
+    string error;
+    version = versions->edit([&](Scene& scene)
+    {
+        SceneObject* obj = nullptr;
+        if (object >= (int)scene.objects.size())
+        {
+            error = "no object " + to_string(object);
+            return false;
+        }
+        if (object >= 0 && (obj = scene.objects[object]->clone()) == nullptr)
+        {
+            error = "object " + to_string(object) + " cannot be edited";
+            return false;
+        }
+        for (auto& change : changes)
+        {
+            const string& key = change.first;
+            const string& value = change.second;
+            float coeff = atof(value.c_str());
+            glm::vec3 v;
+            if (key == "light" && parseVec3(value, scene.lightPos)) continue;
+            if (key == "background" && parseVec3(value, scene.backgroundCol)) continue;
+            if (obj != nullptr)
+            {
+                if (key == "color" && parseVec3(value, v)) { obj->setColor(v); continue; }
+                if (key == "reflect") { obj->setReflectivity(coeff > 0, coeff); continue; }
+                if (key == "transparent") { obj->setTransparency(coeff > 0, coeff); continue; }
+                if (key == "shininess") { obj->setShininess(coeff); continue; }
+            }
+            error = "bad edit: " + key + "=" + value;
+            delete obj;
+            return false;
+        }
+        if (obj != nullptr) scene.replace(object, obj);
+        return true;
+    });
+    return error;
+}
+
+//Executes one command line and returns the reply
+string command(const string& line, int& closeConnection)
+{
+    istringstream in(line);
+    string cmd;
+    in >> cmd;
+
+    if (shuttingDown)
+    {
+        closeConnection = true;
+        return "ERROR shutting down";
+    }
+
+    if (cmd == "RENDER")
+    {
+        shared_ptr<Job> job = make_shared<Job>();
+        string error = parseRender(in, *job);
+        if (!error.empty()) return "ERROR " + error;
+        job->settings.pool = pool;
+        job->settings.cancel = &job->cancel;
+
+        lock_guard<mutex> lock(jobsMutex);
+        if (shuttingDown) return "ERROR shutting down";     //main() may have cancelled the jobs already
+        pruneJobs();
+        job->id = nextJobId++;
+        jobs[job->id] = job;
+        drivers->submit(job->settings.priority, [job]() { runJob(job); });
+        return "OK " + to_string(job->id);
+    }
+
+    if (cmd == "EDIT")
+    {
+        uint64_t version = 0;
+        string error = editScene(in, version);
+        if (!error.empty()) return "ERROR " + error;
+        return "OK " + to_string(version);
+    }
+
+    if (cmd == "STATUS" || cmd == "WAIT" || cmd == "CANCEL")
+    {
+        int id = 0;
+        in >> id;
+        unique_lock<mutex> lock(jobsMutex);
+        auto it = jobs.find(id);
+        if (it == jobs.end()) return "ERROR no such job";
+        shared_ptr<Job> job = it->second;      //Kept alive, as pruneJobs() may forget it while we wait
+
+        if (cmd == "CANCEL")
+        {
+            job->cancel = true;
+            return "OK";
+        }
+        if (cmd == "WAIT")
+            jobFinished.wait(lock, [&]() { return job->status != QUEUED && job->status != RUNNING; });
+        return statusLine(*job);
+    }
+
+    if (cmd == "STATS")
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        int running = 0;
+        for (auto& entry : jobs) if (entry.second->status == RUNNING) running++;
+        ostringstream out;
+        out << "OK scenes=" << sceneCache.size() << " jobs=" << jobs.size()
+            << " running=" << running << " threads=" << pool->size();
+        return out.str();
+    }
+
+    if (cmd == "QUIT")
+    {
+        closeConnection = true;
+        return "OK";
+    }
+
+    if (cmd == "SHUTDOWN")
+    {
+        shuttingDown = true;
+        closeConnection = true;
+        shutdown(listenFd, SHUT_RDWR);      //Wakes up accept()
+        return "OK";
+    }
+
+    return "ERROR unknown command " + cmd;
+}
+
+//Reads command lines from one client until it disconnects
+void serve(int fd)
+{
+    string buffer;
+    char chunk[1024];
+    int closeConnection = false;
+
+    while (!closeConnection)
+    {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n <= 0) break;
+        buffer.append(chunk, n);
+
+        size_t end;
+        while (!closeConnection && (end = buffer.find('\n')) != string::npos)
+        {
+            string line = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            string reply = command(line, closeConnection) + "\n";
+            if (write(fd, reply.data(), reply.size()) < 0) closeConnection = true;
+        }
+    }
+
+    lock_guard<mutex> lock(clientsMutex);
+    clientFds.erase(fd);
+    close(fd);
+    clientsDone.notify_all();
+}
+
+int main(int argc, char *argv[])
+{
+    const char* path = argc > 1 ? argv[1] : DEFAULT_SOCKET;
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    unlink(path);
+    if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0)
+    {
+        cerr << "*** Cannot listen on " << path << endl;
+        return 1;
+    }
+
+    pool = new ThreadPool(threads);
+    drivers = new ThreadPool(MAX_ACTIVE_JOBS);
+    cout << "Render daemon listening on " << path << " with " << pool->size() << " threads" << endl;
+
+    while (!shuttingDown)
+    {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) break;
+        lock_guard<mutex> lock(clientsMutex);
+        clientFds.insert(fd);
+        thread(serve, fd).detach();
+    }
+
+    //Cancel everything still queued or running, then wait for the clients and the
+    //  jobs to end: the clients' commands use the pools
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        for (auto& entry : jobs) entry.second->cancel = true;
+    }
+    {
+        unique_lock<mutex> lock(clientsMutex);
+        for (int fd : clientFds) shutdown(fd, SHUT_RD);    //Ends their reads; replies still go out
+        clientsDone.wait(lock, []() { return clientFds.empty(); });
+    }
+    delete drivers;
+    delete pool;
+    close(listenFd);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,1207 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The renderer
+*  Splits the image into tiles that are rendered by a set
+*  of worker threads.  Anti-aliasing and preview passes
+*  work on a G-buffer covering the tile and a one cell
+*  apron around it, so that tiles are independent.
+-------------------------------------------------------------*/
+
+#include "Renderer.h"
+#include "Shading.h"
+#include "ShadowCache.h"
+#include "Raster.h"
+#include "Checkpoint.h"
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+const int DEADLINE_PREVIEW_SCALE = 8;   //A deadline render's fallback image has 1/8 of its resolution
+
+/**
+* State of the tile a worker thread is rendering.  It is only touched by
+* that thread, so nothing in it needs locking.
+*/
+struct TileContext
+{
+    ShadowCache* shadowCache = nullptr;
+    ShadowCache* probes = nullptr;      //Results of the area light's probe rays (see areaShadow())
+    RasterCache* rasterCache = nullptr;
+    TileFrustum* frustum = nullptr;     //The objects the tile's primary rays can meet
+    uint64_t* touched = nullptr;        //If set, the bits of the objects the tile's rays hit (see Dependencies)
+    long traces = 0;        //Rays traced so far (see CostChannel)
+    long tests = 0;         //Intersection tests made so far
+};
+
+static thread_local TileContext* context = nullptr;
+
+/**
+* The work the calling thread had done at one moment.  The cost of what
+* happens after it is found by costSince().
+*/
+struct CostMark
+{
+    long traces = 0;
+    long tests = 0;
+    std::chrono::steady_clock::time_point time;
+};
+
+static CostMark costMark()
+{
+    CostMark mark;
+    if (context != nullptr)
+    {
+        mark.traces = context->traces;
+        mark.tests = context->tests;
+    }
+    mark.time = std::chrono::steady_clock::now();
+    return mark;
+}
+
+//Cost of the work since 'mark', as held in a cost image
+static glm::vec3 costSince(CostMark& mark)
+{
+    CostMark now = costMark();
+    return glm::vec3(now.traces - mark.traces, now.tests - mark.tests,
+                     std::chrono::duration<float, std::nano>(now.time - mark.time).count());
+}
+
+/**
+* Gives the calling thread a fresh TileContext while in scope.
+*/
+struct ContextScope
+{
+    TileContext tileContext;
+    std::unique_ptr<ShadowCache> shadowCache;
+    std::unique_ptr<ShadowCache> probes;
+    std::unique_ptr<RasterCache> rasterCache;
+    TileContext* outer;
+
+    ContextScope(RenderSettings& settings, bool areaLight, uint64_t* touched = nullptr) : outer(context)
+    {
+        tileContext.touched = touched;
+        if (settings.shadowCache)
+        {
+            shadowCache.reset(new ShadowCache(settings.shadowCacheTolerance));
+            tileContext.shadowCache = shadowCache.get();
+        }
+        if (areaLight)
+        {
+            probes.reset(new ShadowCache(2 * settings.shadowCacheTolerance));     //Coarser: a probe only decides whether to look closer
+            tileContext.probes = probes.get();
+        }
+        if (settings.rasterPrimary)
+        {
+            rasterCache.reset(new RasterCache());
+            tileContext.rasterCache = rasterCache.get();
+        }
+        context = &tileContext;
+    }
+
+    ~ContextScope()
+    {
+        context = outer;
+    }
+};
+
+Renderer::Renderer(Scene& scene, Camera camera, RenderSettings settings) :
+    scene_(scene), camera_(camera), settings_(settings)
+{
+    xmin_ = -settings_.planeWidth * 0.5f;
+    ymin_ = -settings_.planeHeight * 0.5f;
+    cellX_ = settings_.planeWidth / settings_.resolution;
+    cellY_ = settings_.planeHeight / settings_.resolution;
+    sampler_ = createSampler(settings_.sampler);
+    if (settings_.rasterPrimary)
+        raster_.build(scene_.objects, camera_, settings_.planeWidth, settings_.planeHeight,
+                      settings_.edist, settings_.resolution);
+    if (settings_.cullTiles)
+    {
+        float margin = (settings_.previewScale + 1) * std::max(cellX_, cellY_);
+        imageFrustum_.build(scene_.objects, camera_, settings_.edist, xmin_ - margin, ymin_ - margin,
+                            -xmin_ + margin, -ymin_ + margin);
+    }
+}
+
+int Renderer::isCancelled()
+{
+    return settings_.cancel != nullptr && settings_.cancel->load();
+}
+
+/**
+* Primary ray through the point (x, y) of the image plane, whose
+* centre is on the camera's viewing direction.
+*/
+Ray Renderer::primaryRay(float x, float y)
+{
+    return Ray(camera_.eye, camera_.rayDir(x, y, settings_.edist));
+}
+
+//Adds a search of the scene to the thread's context: its tests and the object hit
+static void recordSearch(Ray& ray, int tests)
+{
+    if (context == nullptr) return;
+    context->tests += tests;
+    if (context->touched != nullptr && ray.index != -1) Dependencies::set(context->touched, ray.index);
+}
+
+//---Compares a ray with the scene, counting the intersection tests in the thread's context ---
+//   A ray without a direction, as refraction gives on total internal reflection, meets
+//     nothing; it is not searched for, since a BVH cannot prune a NaN direction.
+//----------------------------------------------------------------------------------
+void Renderer::closestPt(Ray& ray, float maxDist)
+{
+    if (!(glm::dot(ray.dir, ray.dir) > 0))
+    {
+        ray.index = -1;
+        return;
+    }
+    recordSearch(ray, scene_.closestPt(ray, maxDist));
+}
+
+//As closestPt() for a primary ray, using the raster or the tile's frustum when there is one
+void Renderer::closestPrimary(Ray& ray, float maxDist)
+{
+    int tests = -1;
+    if (context != nullptr && context->rasterCache != nullptr)
+        tests = raster_.closestPt(ray, maxDist, *context->rasterCache);
+    if (tests < 0 && context != nullptr && context->frustum != nullptr)
+        tests = context->frustum->closestPt(ray, maxDist);
+    if (tests < 0) closestPt(ray, maxDist);
+    else recordSearch(ray, tests);
+}
+
+//Amount of fog at depth z: 0 for none, 1 for nothing but fog
+float Renderer::fogFactor(float z)
+{
+    return (z-settings_.minFog)/(settings_.maxFog-settings_.minFog);
+}
+
+/**
+* Distance along the ray beyond which fog leaves less than minContribution of
+* any surface, or 1.e+6 if there is no such point.  Rays need not look further.
+*/
+float Renderer::fogDistance(Ray& ray)
+{
+    if (!settings_.fog || settings_.minContribution <= 0) return 1.e+6;
+    float rate = ray.dir.z / (settings_.maxFog - settings_.minFog);    //Fog per unit distance
+    if (rate <= 0) return 1.e+6;
+    return std::max(0.0f, (1 - settings_.minContribution - fogFactor(ray.p0.z)) / rate);
+}
+
+//---Colour of a ray that hit nothing closer than fogDistance() --------------------------
+//   The fog if an object lies beyond that distance, and the background otherwise;
+//     the search beyond is only needed when the two differ.
+//----------------------------------------------------------------------------------
+glm::vec3 Renderer::missColor(Ray& ray)
+{
+    if (fogDistance(ray) >= 1.e+6 || scene_.backgroundCol == settings_.fogColor) return scene_.backgroundCol;
+    Ray beyond = ray;
+    closestPt(beyond);
+    return (beyond.index == -1) ? scene_.backgroundCol : settings_.fogColor;
+}
+
+//---Point where a ray inside 'obj' leaves it -------------------------------------------
+//   For a closed object this is found from the object's own interval, without
+//     searching the scene; anything nested inside the object is not seen.
+//     Otherwise, if the ray does not start inside, or if it leaves through an
+//     open end (see Cylinder::interval()), it is the ray's closest hit in the scene.
+//----------------------------------------------------------------------------------
+glm::vec3 Renderer::exitPoint(SceneObject* obj, Ray& ray)
+{
+    float tEntry, tExit;
+    if (obj->interval(ray.p0, ray.dir, tEntry, tExit) && tEntry <= 0 && tExit > 0)
+    {
+        if (context != nullptr) context->tests++;
+        return ray.p0 + ray.dir * tExit;
+    }
+    closestPt(ray);
+    return ray.hit;
+}
+
+//Closest object between 'hit' and the point 'lightPoint' of the light, as for shadow()
+void Renderer::shadowRay(glm::vec3 hit, glm::vec3 lightPoint, int& occluder, glm::vec3& occluderColor)
+{
+    glm::vec3 lightVec = lightPoint - hit;
+    Ray shadowRay(hit, lightVec);
+    closestPt(shadowRay);
+
+    occluder = -1;
+    occluderColor = glm::vec3(0);
+    if (shadowRay.index > -1 && shadowRay.dist < glm::length(lightVec))
+    {
+        occluder = shadowRay.index;
+        occluderColor = scene_.objects[occluder]->getColor(shadowRay.hit);
+    }
+}
+
+//---Finds the object casting a shadow on the point 'hit' of 'obj' ----------------------
+//   occluder is the index of the closest object between the hit and the light, or
+//     -1 if the point is lit; occluderColor is that object's colour where the shadow
+//     ray meets it.  With the shadow cache enabled, diffuse surfaces reuse the result
+//     of nearby shadow rays of the same tile where they agree.
+//----------------------------------------------------------------------------------
+void Renderer::shadow(SceneObject* obj, glm::vec3 hit, int& occluder, glm::vec3& occluderColor)
+{
+    ShadowCache* cache = nullptr;
+    glm::vec3 normalVec;
+    if (context != nullptr && context->shadowCache != nullptr &&
+        !obj->isReflective() && !obj->isRefractive() && !obj->isTransparent())
+    {
+        cache = context->shadowCache;
+        normalVec = obj->normal(hit);
+        if (cache->lookup(hit, normalVec, occluder, occluderColor)) return;
+    }
+
+    shadowRay(hit, scene_.lightPos, occluder, occluderColor);
+
+    if (cache != nullptr) cache->record(hit, normalVec, occluder, occluderColor);
+}
+
+//Colour of the point 'hit' of 'obj' in the shadow of 'occluder' (none if -1)
+glm::vec3 Renderer::applyShadow(SceneObject* obj, glm::vec3 hit, glm::vec3 surfaceColor, int occluder, glm::vec3 occluderColor)
+{
+    if(occluder > -1) {
+
+        SceneObject* shadowHitObj = scene_.objects[occluder];
+
+        if (shadowHitObj->isTransparent())
+        {
+            surfaceColor = 0.2f * occluderColor * (1-shadowHitObj->getTransparencyCoeff()) + ((shadowHitObj->getTransparencyCoeff()) * surfaceColor);
+        }
+        else if (shadowHitObj->isRefractive())
+        {
+            surfaceColor = 0.8f * (occluderColor * (1-shadowHitObj->getRefractionCoeff()) + ((shadowHitObj->getRefractionCoeff()) * surfaceColor));
+        }
+        else {
+            surfaceColor = 0.1f * obj->getColor(hit);
+        }
+    }
+    return surfaceColor;
+}
+
+//Random value in [0, 1) for each point and salt, the same on every run
+static float jitter(glm::vec3 p, uint32_t salt)
+{
+    uint32_t h = salt * 0x9E3779B1u;
+    for (int k = 0; k < 3; k++)
+    {
+        uint32_t bits;
+        memcpy(&bits, &p[k], sizeof(bits));
+        h = (h ^ bits) * 0x85EBCA6Bu;
+        h ^= h >> 13;
+    }
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return (h >> 8) * (1.0f / 16777216.0f);
+}
+
+//---Soft shadow of an area light on the point 'hit' of 'obj' ----------------------------
+//   Sends one probe ray to a random point in the first quarter of the light.  If
+//     the probes of the tile's points nearby all found the same (see ShadowCache),
+//     the point is taken to be fully lit or fully in shadow, like them, and the
+//     probe alone decides, so such regions cost one ray as a point light does.
+//     Otherwise rays go to the other three quarters: if the four agree, their
+//     average is returned, and if not the point lies in the penumbra, and
+//     penumbraSamples more rays, stratified over the light, refine it.  With the
+//     shadow cache enabled, the four rays of diffuse surfaces are recorded in
+//     it, and points where nearby ones all agreed trace no rays at all.
+//----------------------------------------------------------------------------------
+glm::vec3 Renderer::areaShadow(SceneObject* obj, glm::vec3 hit, glm::vec3 surfaceColor)
+{
+    LightShape& light = scene_.lightShape;
+    ShadowCache* cache = nullptr;
+    glm::vec3 normalVec;
+    if (context != nullptr && context->shadowCache != nullptr &&
+        !obj->isReflective() && !obj->isRefractive() && !obj->isTransparent())
+    {
+        int occluder;
+        glm::vec3 occluderColor;
+        cache = context->shadowCache;
+        normalVec = obj->normal(hit);
+        if (cache->lookup(hit, normalVec, occluder, occluderColor))
+            return applyShadow(obj, hit, surfaceColor, occluder, occluderColor);
+    }
+
+    ShadowCache* probes = (context != nullptr) ? context->probes : nullptr;
+    if (probes != nullptr && cache == nullptr) normalVec = obj->normal(hit);
+
+    glm::vec3 sum(0);
+    int first = 0;
+    int agree = true;
+
+    for (int q = 0; q < 4; q++)
+    {
+        glm::vec2 uv = 0.5f * glm::vec2((q & 1) + jitter(hit, 2 * q), (q >> 1) + jitter(hit, 2 * q + 1));
+        int occluder;
+        glm::vec3 occluderColor;
+        shadowRay(hit, light.point(scene_.lightPos, hit, uv), occluder, occluderColor);
+        sum += applyShadow(obj, hit, surfaceColor, occluder, occluderColor);
+        if (cache != nullptr) cache->record(hit, normalVec, occluder, occluderColor);
+
+        //Every opaque occluder casts the same shadow
+        SceneObject* shadowHitObj = (occluder > -1) ? scene_.objects[occluder] : nullptr;
+        int kind = (shadowHitObj == nullptr) ? -1 :
+                   (shadowHitObj->isTransparent() || shadowHitObj->isRefractive()) ? occluder : -2;
+        if (q == 0)
+        {
+            first = kind;
+            if (probes != nullptr && probes->agrees(hit, normalVec, occluder))
+            {
+                probes->record(hit, normalVec, occluder, occluderColor);
+                return sum;
+            }
+        }
+        else if (kind != first) agree = false;
+        if (probes != nullptr) probes->record(hit, normalVec, occluder, occluderColor);
+    }
+    if (agree) return sum / 4.0f;
+
+    int side = std::max(1, (int)sqrtf((float)settings_.penumbraSamples));
+    for (int b = 0; b < side; b++)
+        for (int a = 0; a < side; a++)
+        {
+            int k = 8 + 2 * (b * side + a);
+            glm::vec2 uv = (1.0f / side) * glm::vec2(a + jitter(hit, k), b + jitter(hit, k + 1));
+            int occluder;
+            glm::vec3 occluderColor;
+            shadowRay(hit, light.point(scene_.lightPos, hit, uv), occluder, occluderColor);
+            sum += applyShadow(obj, hit, surfaceColor, occluder, occluderColor);
+        }
+    return sum / (float)(4 + side * side);
+}
+
+//---Computes the colour value at the closest point of intersection of a ray-----------
+//   The ray must already have been compared with the scene (Scene::closestPt)
+//     and must have hit an object.  surfaceColor is the unshadowed Phong colour
+//     at the hit, from SceneObject::lighting() or shadeBatch().  Points hidden
+//     by fog, and secondary rays that would add less than minContribution after
+//     fog, are not traced.
+//----------------------------------------------------------------------------------
+glm::vec3 Renderer::shade(Ray ray, int step, glm::vec3 surfaceColor)
+{
+    std::vector<SceneObject*>& sceneObjects = scene_.objects;
+    glm::vec3 color(0);
+    SceneObject* obj = sceneObjects[ray.index];     //object on which the closest point of intersection is found
+
+    float fog = settings_.fog ? fogFactor(ray.hit.z) : 0;
+    float visible = 1 - fog;        //Share of this point in the colour
+    if (visible < settings_.minContribution) return settings_.fogColor;
+
+    if (scene_.lightShape.isArea())
+    {
+        surfaceColor = areaShadow(obj, ray.hit, surfaceColor);
+    }
+    else
+    {
+        int occluder;
+        glm::vec3 occluderColor;
+        shadow(obj, ray.hit, occluder, occluderColor);
+        surfaceColor = applyShadow(obj, ray.hit, surfaceColor, occluder, occluderColor);
+    }
+
+    if(obj->isReflective() && step < settings_.maxSteps &&
+       visible * obj->getReflectionCoeff() >= settings_.minContribution)
+    {
+        float rho = obj->getReflectionCoeff();
+        glm::vec3 normalVec = obj->normal(ray.hit);
+        glm::vec3 reflectedDir = glm::reflect(ray.dir, normalVec);
+        Ray reflectedRay(ray.hit, reflectedDir);
+        glm::vec3 reflectedColor = trace(reflectedRay, step + 1);
+        surfaceColor = (1-rho)*surfaceColor + (rho * reflectedColor);
+    }
+
+    if(obj->isRefractive() && step < settings_.maxSteps &&
+       visible * obj->getRefractionCoeff() >= settings_.minContribution)
+    {
+        float rho = obj->getRefractionCoeff();
+        float eta = obj->getRefractiveIndex();
+
+        // Initial Hit
+        glm::vec3 normalVec = obj->normal(ray.hit);
+        glm::vec3 refractedDir = glm::refract(ray.dir, normalVec, eta);
+        Ray refractedRay(ray.hit, refractedDir);
+        glm::vec3 exitPt = exitPoint(obj, refractedRay);
+
+        // Inside Sphere
+        glm::vec3 refNormalVec = obj->normal(exitPt);
+        glm::vec3 exitRayDir = glm::refract(refractedDir, -refNormalVec, 1.0f/eta);
+        Ray exitRay(exitPt, exitRayDir);
+
+        // Recurse for maxSteps
+        glm::vec3 refractedColor = trace(exitRay, step + 1);
+        surfaceColor = (1-rho) * surfaceColor + (rho * refractedColor);
+    }
+
+    if(obj->isTransparent() && step < settings_.maxSteps &&
+       visible * obj->getTransparencyCoeff() >= settings_.minContribution)
+    {
+        float rho = obj->getTransparencyCoeff();
+        Ray transparentRay(ray.hit, ray.dir);
+        Ray exitRay(exitPoint(obj, transparentRay), ray.dir);
+        glm::vec3 transparentColor = trace(exitRay, step + 1);
+        surfaceColor = (1-rho)*surfaceColor + (rho * transparentColor);
+    }
+
+
+    if (settings_.fog)
+    {
+        color += (1-fog)*surfaceColor + fog*settings_.fogColor;
+    }
+    else
+    {
+        color += surfaceColor;
+    }
+
+
+    return color;
+}
+
+glm::vec3 Renderer::shade(Ray ray, int step)
+{
+    SceneObject* obj = scene_.objects[ray.index];
+    if (settings_.fog && 1 - fogFactor(ray.hit.z) < settings_.minContribution) return settings_.fogColor;
+    return shade(ray, step, obj->lighting(scene_.lightPos, -ray.dir, ray.hit));
+}
+
+//---The most important function in a ray tracer! ----------------------------------
+//   Computes the colour value obtained by tracing a ray and finding its
+//     closest point of intersection with objects in the scene.
+//----------------------------------------------------------------------------------
+glm::vec3 Renderer::trace(Ray ray, int step)
+{
+    if (context != nullptr) context->traces++;
+    closestPt(ray, fogDistance(ray));       //Compare the ray with all objects in the scene
+    if(ray.index == -1) return missColor(ray);          //no intersection
+    return shade(ray, step);
+}
+
+//As trace() for a primary ray
+glm::vec3 Renderer::traceCamera(Ray ray)
+{
+    if (context != nullptr) context->traces++;
+    closestPrimary(ray, fogDistance(ray));
+    if(ray.index == -1) return missColor(ray);
+    return shade(ray, 1);
+}
+
+//---Records the first hit of a primary ray in a G-buffer sample --------------------
+//   The ray is compared with the scene, so it can be passed on to shade().
+//----------------------------------------------------------------------------------
+GSample Renderer::firstHit(Ray& ray)
+{
+    GSample sample;
+    if (context != nullptr) context->traces++;
+    closestPrimary(ray, fogDistance(ray));
+    sample.index = ray.index;
+    if (ray.index != -1)
+    {
+        sample.normal = scene_.objects[ray.index]->normal(ray.hit);
+        sample.depth = ray.dist;
+    }
+    return sample;
+}
+
+//---Traces a batch of primary rays ---------------------------------------------------
+//   Records the first hit of every ray and shades all hits together with
+//     shadeBatch(), before adding shadows and secondary rays one by one.  If
+//     costs is given, it receives the cost of each ray, except its share of
+//     shadeBatch().
+//----------------------------------------------------------------------------------
+void Renderer::tracePrimary(std::vector<Ray>& rays, std::vector<GSample>& samples, std::vector<glm::vec3>& colors,
+                            std::vector<glm::vec3>* costs)
+{
+    std::vector<HitRecord> hits;
+    std::vector<glm::vec3> lit;
+    samples.resize(rays.size());
+    colors.resize(rays.size());
+    if (costs != nullptr) costs->assign(rays.size(), glm::vec3(0));
+    CostMark mark;
+
+    for (size_t k = 0; k < rays.size(); k++)
+    {
+        Ray& ray = rays[k];
+        if (costs != nullptr) mark = costMark();
+        samples[k] = firstHit(ray);
+        if (costs != nullptr) (*costs)[k] += costSince(mark);
+        if (ray.index == -1) continue;
+        HitRecord hit;
+        hit.pos = ray.hit;
+        hit.normal = samples[k].normal;
+        hit.view = -ray.dir;
+        hit.color = scene_.objects[ray.index]->getColor(ray.hit);
+        hit.index = ray.index;
+        hits.push_back(hit);
+    }
+
+    shadeBatch(scene_.lightPos, hits, scene_.objects, lit);
+
+    size_t n = 0;
+    for (size_t k = 0; k < rays.size(); k++)
+    {
+        if (costs != nullptr) mark = costMark();
+        if (rays[k].index == -1) colors[k] = missColor(rays[k]);
+        else colors[k] = shade(rays[k], 1, lit[n++]);
+        if (costs != nullptr) (*costs)[k] += costSince(mark);
+    }
+}
+
+int Renderer::isDistinct(glm::vec3 color1, glm::vec3 ave)
+{
+    return (fabs(color1.x - ave.x) > settings_.colDiff) ||
+    (fabs(color1.y - ave.y) > settings_.colDiff) ||
+    (fabs(color1.z - ave.z) > settings_.colDiff);
+}
+
+//Most rays aliasing() may trace for one cell
+long Renderer::pixelSampleCap()
+{
+    return (settings_.maxPixelSamples > 0) ? std::max(settings_.maxPixelSamples, 4) : LONG_MAX;
+}
+
+//---Adaptive supersampling of the cell at (xp, yp) ---------------------------------
+//   Traces four rays and subdivides every quadrant whose colour differs from
+//     the average, up to maxAliasSteps levels and at most maxPixelSamples rays
+//     (four at least).
+//----------------------------------------------------------------------------------
+glm::vec3 Renderer::aliasing(float xp, float yp, float cellX, float cellY, int step)
+{
+    long samplesLeft = pixelSampleCap();
+    int i = (int)floorf((xp - xmin_) / cellX_ + 0.5f);
+    int j = (int)floorf((yp - ymin_) / cellY_ + 0.5f);
+    return aliasing(xp, yp, cellX, cellY, step, samplesLeft, i, j, 0);
+}
+
+//   As above for quadtree node 'node' of cell (i, j), tracing at most samplesLeft
+//     rays (four at least), which is reduced by the number traced.  The sampler
+//     places the four rays; the quadrants that need subdividing share the rays
+//     that are left equally.
+glm::vec3 Renderer::aliasing(float xp, float yp, float cellX, float cellY, int step, long& samplesLeft, int i, int j, int node)
+{
+    glm::vec2 points[4];
+    sampler_->quad(i, j, node, points);
+
+    glm::vec3 cols[4];
+    for (int q = 0; q < 4; q++)
+    {
+        Ray ray = primaryRay(xp + (double)points[q].x*cellX, yp + (double)points[q].y*cellY);
+        cols[q] = traceCamera(ray);
+    }
+    samplesLeft -= 4;
+
+    glm::vec3 ave = (cols[0] + cols[1] + cols[2] + cols[3]) / 4.0f;
+
+    if (step >= settings_.maxAliasSteps) {
+        return ave;
+    } else {
+        const float dx[4] = {0, 0.5f, 0, 0.5f};
+        const float dy[4] = {0, 0, 0.5f, 0.5f};
+        int distinct[4];
+        int toSplit = 0;
+        for (int q = 0; q < 4; q++)
+        {
+            distinct[q] = isDistinct(cols[q], ave);
+            toSplit += distinct[q];
+        }
+
+        for (int q = 0; q < 4; q++)
+        {
+            if (!distinct[q]) continue;
+            long share = samplesLeft / toSplit--;
+            if (share < 4) continue;
+            long left = share;
+            cols[q] = aliasing(xp + dx[q]*cellX, yp + dy[q]*cellY, cellX*0.5f, cellY*0.5f, step+1, left,
+                               i, j, 4*node + 1 + q);
+            samplesLeft -= share - left;
+        }
+
+        return (cols[0] + cols[1] + cols[2] + cols[3]) / 4.0f;
+    }
+}
+
+//---Checks whether a cell of the one-ray-per-cell G-buffer needs anti-aliasing ---------
+// A cell is on an edge if any of its four neighbours hits a different object, a
+// surface with a different normal or depth, or has a distinct colour.  Thin
+// geometry of a similar colour to its surroundings is caught by the first tests.
+//---------------------------------------------------------------------------------------
+int Renderer::isEdge(GBuffer& gbuffer, int i, int j)
+{
+    const int di[4] = {-1, 1, 0, 0};
+    const int dj[4] = {0, 0, -1, 1};
+    GSample& sample = gbuffer.sampleAt(i, j);
+    glm::vec3 col = gbuffer.colorAt(i, j);
+
+    for (int k = 0; k < 4; k++)
+    {
+        int ni = i + di[k];
+        int nj = j + dj[k];
+        if (ni < 0 || ni >= gbuffer.getWidth() || nj < 0 || nj >= gbuffer.getHeight()) continue;
+        if (!isCompatible(sample, gbuffer.sampleAt(ni, nj))) return true;
+        if (isDistinct(col, gbuffer.colorAt(ni, nj))) return true;
+    }
+    return false;
+}
+
+//---Estimated error of a cell of the one-ray-per-cell G-buffer ---------------------------
+// The largest colour difference to a neighbour, plus colDiff if that neighbour is on
+// another surface; -1 if the cell is not on an edge (see isEdge()).
+//---------------------------------------------------------------------------------------
+float Renderer::edgeError(GBuffer& gbuffer, int i, int j)
+{
+    const int di[4] = {-1, 1, 0, 0};
+    const int dj[4] = {0, 0, -1, 1};
+    GSample& sample = gbuffer.sampleAt(i, j);
+    glm::vec3 col = gbuffer.colorAt(i, j);
+    float error = -1;
+
+    for (int k = 0; k < 4; k++)
+    {
+        int ni = i + di[k];
+        int nj = j + dj[k];
+        if (ni < 0 || ni >= gbuffer.getWidth() || nj < 0 || nj >= gbuffer.getHeight()) continue;
+        glm::vec3 diff = glm::abs(col - gbuffer.colorAt(ni, nj));
+        float colorError = std::max(diff.x, std::max(diff.y, diff.z));
+        if (!isCompatible(sample, gbuffer.sampleAt(ni, nj))) error = std::max(error, colorError + settings_.colDiff);
+        else if (colorError > settings_.colDiff) error = std::max(error, colorError);
+    }
+    return error;
+}
+
+//---Traces one ray through the centre of each cell covered by a G-buffer ---------------
+// The image plane is divided into div x div cells and the G-buffer's sample (0, 0)
+// is cell (x0, y0).  One batch of rays per column.  If costs is given, an image the
+// size of the G-buffer, it receives the cost of each sample.
+//---------------------------------------------------------------------------------------
+void Renderer::traceRegion(GBuffer& gbuffer, int div, int x0, int y0, Image* costs)
+{
+    float cellX = settings_.planeWidth / div;
+    float cellY = settings_.planeHeight / div;
+    int width = gbuffer.getWidth();
+    int height = gbuffer.getHeight();
+    std::vector<Ray> rays(height);
+    std::vector<GSample> samples;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec3> rayCosts;
+
+    for (int i = 0; i < width; i++)
+    {
+        if (isCancelled()) return;
+        float xp = xmin_ + (x0 + i)*cellX;
+        for (int j = 0; j < height; j++)
+        {
+            float yp = ymin_ + (y0 + j)*cellY;
+            rays[j] = primaryRay(xp+0.5*cellX, yp+0.5*cellY);
+        }
+        tracePrimary(rays, samples, colors, (costs != nullptr) ? &rayCosts : nullptr);
+        for (int j = 0; j < height; j++)
+        {
+            gbuffer.sampleAt(i, j) = samples[j];
+            gbuffer.colorAt(i, j) = colors[j];
+            if (costs != nullptr) costs->at(i, j) = rayCosts[j];
+        }
+    }
+}
+
+//---Geometry-aware anti-aliasing of a tile -----------------------------------------------
+// First traces one ray through the centre of each cell of the tile and its apron,
+// recording first hits and colours in a G-buffer, then supersamples only the cells
+// on an object, normal or colour edge.  Without anti-aliasing the G-buffer colours
+// are the image.  If deferred is given, edge cells keep their G-buffer colour and
+// are added to it instead, to be supersampled later.  The cost of the apron, which
+// is traced again by the neighbouring tiles, is left out of the cost image.
+//---------------------------------------------------------------------------------------
+void Renderer::antiAliasTile(Tile& tile, Image& image, std::vector<EdgeCell>* deferred)
+{
+    int res = settings_.resolution;
+    int apron = settings_.antiAliasing ? 1 : 0;
+    int gx0 = std::max(tile.x0 - apron, 0);
+    int gy0 = std::max(tile.y0 - apron, 0);
+    int gx1 = std::min(tile.x1 + apron, res);
+    int gy1 = std::min(tile.y1 + apron, res);
+    GBuffer gbuffer(gx1 - gx0, gy1 - gy0);
+    Image* costs = settings_.costImage;
+    Image regionCosts;
+    if (costs != nullptr) regionCosts = Image(gx1 - gx0, gy1 - gy0);
+
+    traceRegion(gbuffer, res, gx0, gy0, (costs != nullptr) ? &regionCosts : nullptr);
+
+    for (int i = tile.x0; i < tile.x1; i++)
+    {
+        if (isCancelled()) return;
+        float xp = xmin_ + i*cellX_;
+        for (int j = tile.y0; j < tile.y1; j++)
+        {
+            float yp = ymin_ + j*cellY_;
+            if (costs != nullptr) costs->at(i, j) = regionCosts.at(i - gx0, j - gy0);
+            if (deferred != nullptr)
+            {
+                image.at(i, j) = gbuffer.colorAt(i - gx0, j - gy0);
+                float error = edgeError(gbuffer, i - gx0, j - gy0);
+                if (error >= 0) deferred->push_back({i, j, error});
+            }
+            else if (settings_.antiAliasing && isEdge(gbuffer, i - gx0, j - gy0))
+            {
+                CostMark mark;
+                if (costs != nullptr) mark = costMark();
+                long samplesLeft = pixelSampleCap();
+                image.at(i, j) = aliasing(xp, yp, cellX_, cellY_, 1, samplesLeft, i, j, 0);
+                if (costs != nullptr) costs->at(i, j) += costSince(mark);
+            }
+            else
+                image.at(i, j) = gbuffer.colorAt(i - gx0, j - gy0);
+        }
+    }
+}
+
+//---Preview rendering of a tile ----------------------------------------------------------
+// Traces one ray through the centre of every previewScale x previewScale block of
+// cells, recording its first hit in a G-buffer, and reconstructs the full grid
+// from it.  Cells whose neighbouring samples lie on one surface are interpolated
+// directly; cells near an object or normal edge get a primary ray of their own
+// and only blend samples that lie on the same surface, so edges stay sharp.
+// Cells on geometry the coarse grid missed entirely are traced in full.  In the
+// cost image, each coarse sample counts towards the cell at its centre.
+//---------------------------------------------------------------------------------------
+void Renderer::previewTile(Tile& tile, Image& image)
+{
+    int scale = settings_.previewScale;
+    int lowDiv = (settings_.resolution + scale - 1) / scale;
+    int gx0 = std::max(tile.x0 / scale - 1, 0);
+    int gy0 = std::max(tile.y0 / scale - 1, 0);
+    int gx1 = std::min((tile.x1 + scale - 1) / scale + 1, lowDiv);
+    int gy1 = std::min((tile.y1 + scale - 1) / scale + 1, lowDiv);
+    GBuffer gbuffer(gx1 - gx0, gy1 - gy0);
+    Image* costs = settings_.costImage;
+    Image regionCosts;
+    if (costs != nullptr) regionCosts = Image(gx1 - gx0, gy1 - gy0);
+    CostMark mark;
+
+    traceRegion(gbuffer, lowDiv, gx0, gy0, (costs != nullptr) ? &regionCosts : nullptr);
+
+    for (int i = tile.x0; i < tile.x1; i++)
+    {
+        if (isCancelled()) return;
+        float xp = xmin_ + i*cellX_;
+        float x = (i + 0.5f) / scale - gx0;     //Cell centre in G-buffer units
+        for (int j = tile.y0; j < tile.y1; j++)
+        {
+            float yp = ymin_ + j*cellY_;
+            float y = (j + 0.5f) / scale - gy0;
+            glm::vec3& col = image.at(i, j);
+            if (costs != nullptr) mark = costMark();
+
+            if (!gbuffer.interpolate(x, y, col))
+            {
+                Ray ray = primaryRay(xp+0.5*cellX_, yp+0.5*cellY_);
+                GSample hit = firstHit(ray);
+                if (!gbuffer.upsample(hit, x, y, col))
+                    col = (ray.index == -1) ? missColor(ray) : shade(ray, 1);
+            }
+            if (costs != nullptr) costs->at(i, j) = costSince(mark);
+        }
+    }
+
+    if (costs == nullptr) return;
+    for (int gi = gx0; gi < gx1; gi++)
+        for (int gj = gy0; gj < gy1; gj++)
+        {
+            int i = gi * scale + scale / 2;
+            int j = gj * scale + scale / 2;
+            if (i >= tile.x0 && i < tile.x1 && j >= tile.y0 && j < tile.y1)
+                costs->at(i, j) += regionCosts.at(gi - gx0, gj - gy0);
+        }
+}
+
+//Splits the image into tiles of tileSize x tileSize cells, row by row
+std::vector<Tile> Renderer::tiles()
+{
+    std::vector<Tile> result;
+    int res = settings_.resolution;
+    int size = settings_.tileSize;
+    if (settings_.previewScale > 1) size = (size + settings_.previewScale - 1) / settings_.previewScale * settings_.previewScale;
+    for (int y = 0; y < res; y += size)
+        for (int x = 0; x < res; x += size)
+            result.push_back({x, y, std::min(x + size, res), std::min(y + size, res)});
+    return result;
+}
+
+/**
+* Renders one tile into image.  If touched is given, the bits of the objects
+* the tile's rays hit are set in it (see Dependencies).
+*/
+void Renderer::renderTile(Tile& tile, Image& image, std::vector<EdgeCell>* deferred, uint64_t* touched)
+{
+    ContextScope scope(settings_, scene_.lightShape.isArea(), touched);
+    TileFrustum frustum;
+    if (settings_.cullTiles && tileFrustum(tile, frustum)) scope.tileContext.frustum = &frustum;
+    double start = (settings_.timeline != nullptr) ? settings_.timeline->now() : 0;
+    if (settings_.previewScale > 1) previewTile(tile, image);
+    else antiAliasTile(tile, image, deferred);
+    if (settings_.timeline != nullptr) settings_.timeline->record("tile", tile, start, settings_.timeline->now());
+}
+
+//---Finds the objects a tile's primary rays can meet ---------------------------------
+//   The frustum covers the tile, the apron of its G-buffer and a preview's
+//     coarser cells.  Returns false if the scene has a BVH and the tile sees
+//     any object: the BVH then makes fewer tests than the list.
+//----------------------------------------------------------------------------------
+bool Renderer::tileFrustum(Tile& tile, TileFrustum& frustum)
+{
+    int margin = settings_.previewScale + 1;
+    frustum.build(scene_.objects, camera_, settings_.edist,
+                  xmin_ + (tile.x0 - margin) * cellX_, ymin_ + (tile.y0 - margin) * cellY_,
+                  xmin_ + (tile.x1 + margin) * cellX_, ymin_ + (tile.y1 + margin) * cellY_, &imageFrustum_);
+    return frustum.size() == 0 || scene_.getBVHStats().nodes == 0;
+}
+
+//Number of threads a render runs on
+int Renderer::workerCount()
+{
+    if (settings_.pool != nullptr) return settings_.pool->size();
+    return settings_.threads > 0 ? settings_.threads : std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+/**
+* Calls fn(k) for every k in [0, count), spread over the worker threads,
+* until the render is cancelled.  With a shared pool, every call is a task
+* at the render's priority and this thread waits for them.
+*/
+void Renderer::runWorkers(int count, std::function<void(int)> fn)
+{
+    if (count == 0) return;
+    if (settings_.pool != nullptr)
+    {
+        std::mutex mutex;
+        std::condition_variable finished;
+        int remaining = count;
+        for (int k = 0; k < count; k++)
+        {
+            settings_.pool->submit(settings_.priority, [&, k]()
+            {
+                if (!isCancelled()) fn(k);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--remaining == 0) finished.notify_all();
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]() { return remaining == 0; });
+        return;
+    }
+
+    std::atomic<int> next(0);
+
+    auto worker = [&]()
+    {
+        for (int k = next++; k < count && !isCancelled(); k = next++)
+            fn(k);
+    };
+
+    std::vector<std::thread> pool;
+    for (int k = 1; k < workerCount(); k++) pool.push_back(std::thread(worker));
+    worker();
+    for (std::thread& t : pool) t.join();
+}
+
+/**
+* Fingerprint of the view and of the settings that change pixels, so that a
+* checkpoint is only resumed by a render that would have made the same tiles.
+*/
+uint64_t Renderer::settingsHash()
+{
+    Fingerprint print;
+    print.add(camera_.eye);
+    print.add(camera_.yaw);
+    print.add(camera_.pitch);
+    RenderSettings& s = settings_;
+    int ints[] = {s.resolution, s.maxSteps, s.antiAliasing, s.maxAliasSteps, (int)s.sampler, s.maxPixelSamples,
+                  s.fog, s.previewScale, s.tileSize, s.shadowCache, s.penumbraSamples};
+    float floats[] = {s.planeWidth, s.planeHeight, s.edist, s.colDiff, s.minFog, s.maxFog,
+                      s.minContribution, s.shadowCacheTolerance};
+    print.add(ints);
+    print.add(floats);
+    print.add(s.fogColor);
+    return print.value();
+}
+
+/**
+* Renders the whole image, handing each tile to the sink as soon as it is
+* done; only the tiles being rendered are held in memory.  Worker threads
+* take tiles in turn until none are left, or until the render is cancelled;
+* a tile interrupted by cancellation is dropped.  With a checkpoint file, the
+* tiles it holds are handed to the sink first and only the others rendered.
+*
+* With a sample budget or a deadline, anti-aliasing is left to the end and
+* spent on the worst cells of the whole image first (see renderBudgeted()).
+* Such renders record no dependencies.
+*/
+void Renderer::render(TileSink& sink)
+{
+    Dependencies* deps = settings_.dependencies;
+    if (settings_.antiAliasing && settings_.previewScale <= 1 &&
+        (settings_.sampleBudget > 0 || settings_.deadlineMs > 0))
+    {
+        if (deps != nullptr) deps->reset(0, 0, 0);
+        renderBudgeted(sink);
+        return;
+    }
+
+    std::vector<Tile> work = tiles();
+    std::vector<char> restored(work.size(), 0);
+    int done = 0;
+    if (deps != nullptr)
+    {
+        deps->reset((int)work.size(), (int)scene_.objects.size(), settingsHash());
+        deps->recordBounds(scene_.objects);
+    }
+
+    Checkpoint checkpoint;
+    if (!settings_.checkpoint.empty())
+    {
+        checkpoint.open(settings_.checkpoint.c_str(), scene_.hash(), settingsHash(), work, settings_.checkpointSeconds,
+                        [&](int t, Image& pixels)
+        {
+            sink.write(work[t], pixels);
+            if (deps != nullptr) deps->setAll(t);      //Its rays are not known
+            restored[t] = 1;
+            done++;
+        });
+        if (done > 0 && settings_.progress) settings_.progress(done, (int)work.size());
+    }
+    std::vector<int> left;
+    for (int t = 0; t < (int)work.size(); t++)
+        if (!restored[t]) left.push_back(t);
+
+    renderTiles(work, left, sink, &checkpoint, done, (int)work.size());
+    checkpoint.close();
+}
+
+//---Renders the tiles work[k] for k in 'which' and hands them to the sink -------------
+//   Each is recorded in the checkpoint, if given, and in the dependencies, if kept.
+//     Progress counts on from 'done' of 'total'.
+//----------------------------------------------------------------------------------
+void Renderer::renderTiles(std::vector<Tile>& work, std::vector<int>& which, TileSink& sink, Checkpoint* checkpoint,
+                           int done, int total)
+{
+    Dependencies* deps = settings_.dependencies;
+    std::mutex progressMutex;
+
+    runWorkers((int)which.size(), [&](int k)
+    {
+        int t = which[k];
+        Tile& tile = work[t];
+        Image pixels(tile.x1 - tile.x0, tile.y1 - tile.y0, tile.x0, tile.y0);
+        if (deps != nullptr) deps->clear(t);
+        renderTile(tile, pixels, nullptr, (deps != nullptr) ? deps->tile(t) : nullptr);
+        if (isCancelled())
+        {
+            if (deps != nullptr) deps->setAll(t);      //Not in the sink, so out of date whatever is edited
+            return;
+        }
+        sink.write(tile, pixels);
+        if (checkpoint != nullptr) checkpoint->record(t, pixels);
+        if (settings_.progress)
+        {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            settings_.progress(++done, total);
+        }
+    });
+}
+
+/**
+* Renders again, after the given objects were edited, only the tiles that
+* depend on them (see Dependencies.h), handing those to the sink.  Without
+* dependencies recorded by the last render of the same view, settings and
+* number of objects, or once an edited object's bounds have changed, the
+* whole image is rendered: a moved object can enter tiles and shadow rays
+* that never met it.  Returns the number of tiles rendered.
+*/
+int Renderer::rerender(TileSink& sink, const std::vector<int>& changed)
+{
+    Dependencies* deps = settings_.dependencies;
+    std::vector<Tile> work = tiles();
+    if (deps == nullptr || !deps->matches((int)work.size(), (int)scene_.objects.size(), settingsHash()) ||
+        deps->moved(scene_.objects, changed))
+    {
+        render(sink);
+        return (int)work.size();
+    }
+    std::vector<int> which = deps->affected(changed);
+    renderTiles(work, which, sink, nullptr, 0, (int)which.size());
+    return (int)which.size();
+}
+
+//---Renders with a limited number of anti-aliasing rays or a deadline -------------------
+// First traces one ray per cell over the whole image, recording every edge cell with
+// an estimate of its error; progress is reported as these tiles finish.  Then the
+// edge cells are supersampled worst first, until sampleBudget rays have been traced
+// or deadlineMs has passed, and the image is handed to the sink.  With a deadline,
+// a low resolution image is traced first, and tiles of the first pass not begun by
+// the deadline are filled from it, so the image is late by at most that image and
+// one tile per thread.  The image is kept in memory throughout.
+//---------------------------------------------------------------------------------------
+void Renderer::renderBudgeted(TileSink& sink)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double, std::milli>(settings_.deadlineMs);
+    auto expired = [&]() { return settings_.deadlineMs > 0 && std::chrono::steady_clock::now() >= deadline; };
+    int res = settings_.resolution;
+    Image image(res, res);
+    Image coarse;
+    if (settings_.deadlineMs > 0)
+    {
+        RenderSettings preview = settings_;
+        preview.resolution = std::max(res / DEADLINE_PREVIEW_SCALE, 1);
+        preview.antiAliasing = false;
+        preview.sampleBudget = 0;
+        preview.deadlineMs = 0;
+        preview.checkpoint.clear();
+        preview.progress = nullptr;
+        preview.costImage = nullptr;
+        preview.timeline = nullptr;
+        preview.dependencies = nullptr;
+        coarse = Renderer(scene_, camera_, preview).render();
+        if (isCancelled()) return;
+    }
+    std::vector<Tile> work = tiles();
+    std::vector<EdgeCell> edges;
+    std::mutex mutex;
+    int done = 0;
+
+    runWorkers((int)work.size(), [&](int t)
+    {
+        std::vector<EdgeCell> tileEdges;
+        Tile& tile = work[t];
+        if (!expired()) renderTile(tile, image, &tileEdges);
+        else
+        {
+            int lowRes = coarse.getWidth();
+            for (int j = tile.y0; j < tile.y1; j++)
+                for (int i = tile.x0; i < tile.x1; i++)
+                    image.at(i, j) = coarse.at(i * lowRes / res, j * lowRes / res);
+        }
+        if (isCancelled()) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        edges.insert(edges.end(), tileEdges.begin(), tileEdges.end());
+        if (settings_.progress) settings_.progress(++done, (int)work.size());
+    });
+    if (isCancelled()) return;
+
+    std::sort(edges.begin(), edges.end(), [](const EdgeCell& a, const EdgeCell& b)
+    {
+        if (a.error != b.error) return a.error > b.error;
+        return (a.j != b.j) ? a.j < b.j : a.i < b.i;
+    });
+
+    std::atomic<long> budget(settings_.sampleBudget > 0 ? settings_.sampleBudget : LONG_MAX);
+    long cap = 0;           //Most rays aliasing() can trace for one cell
+    for (int step = 0; step < settings_.maxAliasSteps; step++) cap = cap * 4 + 4;
+    cap = std::min(cap, pixelSampleCap());
+    std::atomic<int> next(0);
+
+    runWorkers(workerCount(), [&](int)
+    {
+        ContextScope scope(settings_, scene_.lightShape.isArea());
+        Timeline* timeline = settings_.timeline;
+        double started = (timeline != nullptr) ? timeline->now() : 0;
+        Tile cells = {settings_.resolution, settings_.resolution, 0, 0};   //Bounds of the cells taken
+        while (!isCancelled())
+        {
+            if (expired()) break;
+
+            //Take up to one cell's worth of rays from the budget, and return what is not used
+            long available = budget.load();
+            long taken = 0;
+            while (available >= 4)
+            {
+                taken = std::min(cap, available);
+                if (budget.compare_exchange_weak(available, available - taken)) break;
+                taken = 0;
+            }
+            if (taken == 0) break;
+
+            int k = next++;
+            if (k >= (int)edges.size())
+            {
+                budget += taken;
+                break;
+            }
+            EdgeCell& cell = edges[k];
+            long left = taken;
+            CostMark mark;
+            if (settings_.costImage != nullptr) mark = costMark();
+            image.at(cell.i, cell.j) = aliasing(xmin_ + cell.i*cellX_, ymin_ + cell.j*cellY_, cellX_, cellY_, 1, left,
+                                                cell.i, cell.j, 0);
+            if (settings_.costImage != nullptr) settings_.costImage->at(cell.i, cell.j) += costSince(mark);
+            budget += left;
+            if (timeline != nullptr) cells = {std::min(cells.x0, cell.i), std::min(cells.y0, cell.j),
+                                              std::max(cells.x1, cell.i + 1), std::max(cells.y1, cell.j + 1)};
+        }
+        if (timeline != nullptr && cells.x0 < cells.x1) timeline->record("anti-aliasing", cells, started, timeline->now());
+    });
+    if (isCancelled()) return;
+
+    for (Tile& tile : work)
+    {
+        Image pixels(tile.x1 - tile.x0, tile.y1 - tile.y0, tile.x0, tile.y0);
+        for (int j = tile.y0; j < tile.y1; j++)
+            for (int i = tile.x0; i < tile.x1; i++)
+                pixels.at(i, j) = image.at(i, j);
+        sink.write(tile, pixels);
+    }
+}
+
+//Copies tiles into one image
+class ImageSink : public TileSink
+{
+private:
+    Image& image_;
+
+public:
+    ImageSink(Image& image) : image_(image) {}
+
+    void write(Tile& tile, Image& pixels)
+    {
+        for (int j = tile.y0; j < tile.y1; j++)
+            for (int i = tile.x0; i < tile.x1; i++)
+                image_.at(i, j) = pixels.at(i, j);
+    }
+};
+
+/**
+* Renders the whole image into memory.  A cancelled render returns the
+* tiles completed so far.
+*/
+Image Renderer::render()
+{
+    Image image(settings_.resolution, settings_.resolution);
+    ImageSink sink(image);
+    render(sink);
+    return image;
+}
+
+Image render(Scene& scene, Camera camera, RenderSettings settings)
+{
+    Renderer renderer(scene, camera, settings);
+    return renderer.render();
+}
+
+void render(Scene& scene, Camera camera, RenderSettings settings, TileSink& sink)
+{
+    Renderer renderer(scene, camera, settings);
+    renderer.render(sink);
+}
+
+//Updates an image rendered with settings.dependencies after the given objects were edited
+int rerender(Scene& scene, Camera camera, RenderSettings settings, Image& image, const std::vector<int>& changed)
+{
+    Renderer renderer(scene, camera, settings);
+    ImageSink sink(image);
+    return renderer.rerender(sink, changed);
+}
@@ -0,0 +1,153 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The renderer
+*  Ray traces a Scene seen from a Camera into an Image, or
+*  tile by tile into a TileSink.
+*  All state of a render lives in its Renderer, so any
+*  number of renders, of the same or different scenes, can
+*  run at the same time in one process.  The scene is only
+*  read during a render.
+-------------------------------------------------------------*/
+
+#ifndef H_RENDERER
+#define H_RENDERER
+#include <glm/glm.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Scene.h"
+#include "Camera.h"
+#include "Image.h"
+#include "TileSink.h"
+#include "Ray.h"
+#include "GBuffer.h"
+#include "ThreadPool.h"
+#include "Sampler.h"
+#include "Profile.h"
+#include "Raster.h"
+#include "Frustum.h"
+#include "Dependencies.h"
+
+/**
+ * Options of a single render.  The defaults reproduce the
+ * original assignment image.
+ */
+struct RenderSettings
+{
+    int resolution = 600;           //Cells along each side of the image plane
+    float planeWidth = 100;         //Size of the image plane
+    float planeHeight = 100;
+    float edist = 100;              //Distance from the eye to the image plane
+    int maxSteps = 5;               //Maximum depth of secondary rays
+    int antiAliasing = true;
+    int maxAliasSteps = 5;          //Maximum subdivision depth of an anti-aliased cell
+    float colDiff = 0.2f;           //Colour difference that triggers anti-aliasing
+    SamplerType sampler = SAMPLER_REGULAR;  //Where anti-aliasing rays pass through a cell
+    int maxPixelSamples = 0;        //Most anti-aliasing rays for one cell; 0 for no limit
+    long sampleBudget = 0;          //Most anti-aliasing rays for the whole image; 0 for no limit
+    double deadlineMs = 0;          //Hand back the best image so far this long after the render starts; 0 for no deadline
+    int fog = true;
+    float minFog = -20;             //z at which fog starts
+    float maxFog = -200;            //z at which fog is complete
+    glm::vec3 fogColor = glm::vec3(0.8f);
+    float minContribution = 1.0f / 512;     //Shading and secondary rays adding less to a cell are skipped; 0 traces all
+    int previewScale = 1;           //1 = full quality; 2 or 4 traces 1/4 or 1/16 of the cells and upsamples
+    int threads = 0;                //Worker threads; 0 uses one per hardware thread
+    ThreadPool* pool = nullptr;     //If set, tiles run on this shared pool instead of new threads
+    int priority = 0;               //Priority of this render's tiles on the pool
+    int tileSize = 32;              //Cells along each side of a tile, the unit of work of a thread
+    int shadowCache = false;        //Reuse shadow rays of nearby points on diffuse surfaces
+    float shadowCacheTolerance = 0.25f;     //Cell size of the shadow cache, in scene units
+    int rasterPrimary = false;      //Find the first hits of primary rays from a rasterization (see Raster.h)
+    int cullTiles = false;          //Compare each tile's primary rays only with the objects in its frustum (see Frustum.h)
+    int penumbraSamples = 16;       //More shadow rays (a square number) where the first four to an area light disagree
+    std::string checkpoint;         //If set, finished tiles are saved to this file, and resumed from it (see Checkpoint.h);
+                                    //  ignored with a budget or deadline
+    double checkpointSeconds = 30;  //Most time between checkpoint writes; not used with a budget or deadline
+    const std::atomic<bool>* cancel = nullptr;  //If set, the render stops as soon as it can
+    std::function<void(int done, int total)> progress;  //If set, called (one call at a time) as each tile finishes
+    Image* costImage = nullptr;     //If set, a resolution x resolution image given the cost of every cell (see Profile.h)
+    Timeline* timeline = nullptr;   //If set, records when each tile runs on which thread
+    Dependencies* dependencies = nullptr;   //If set, records the objects each tile depends on, for rerender()
+};
+
+/**
+ * A cell that anti-aliasing would improve, with an estimate of its error.
+ */
+struct EdgeCell
+{
+    int i, j;
+    float error;
+};
+
+class Checkpoint;
+
+class Renderer
+{
+private:
+    Scene& scene_;
+    Camera camera_;
+    RenderSettings settings_;
+    float xmin_;        //Bottom-left corner of the image plane
+    float ymin_;
+    float cellX_;       //Cell width
+    float cellY_;       //Cell height
+    std::unique_ptr<Sampler> sampler_;
+    PrimaryRaster raster_;      //Built if settings_.rasterPrimary
+    TileFrustum imageFrustum_;  //Built if settings_.cullTiles
+
+    void closestPt(Ray& ray, float maxDist = 1.e+6);
+    void closestPrimary(Ray& ray, float maxDist);
+    bool tileFrustum(Tile& tile, TileFrustum& frustum);
+    float fogFactor(float z);
+    float fogDistance(Ray& ray);
+    glm::vec3 missColor(Ray& ray);
+    glm::vec3 exitPoint(SceneObject* obj, Ray& ray);
+    void shadowRay(glm::vec3 hit, glm::vec3 lightPoint, int& occluder, glm::vec3& occluderColor);
+    void shadow(SceneObject* obj, glm::vec3 hit, int& occluder, glm::vec3& occluderColor);
+    glm::vec3 applyShadow(SceneObject* obj, glm::vec3 hit, glm::vec3 surfaceColor, int occluder, glm::vec3 occluderColor);
+    glm::vec3 areaShadow(SceneObject* obj, glm::vec3 hit, glm::vec3 surfaceColor);
+    glm::vec3 shade(Ray ray, int step, glm::vec3 surfaceColor);
+    glm::vec3 traceCamera(Ray ray);
+    GSample firstHit(Ray& ray);
+    void tracePrimary(std::vector<Ray>& rays, std::vector<GSample>& samples, std::vector<glm::vec3>& colors,
+                      std::vector<glm::vec3>* costs = nullptr);
+    int isDistinct(glm::vec3 color1, glm::vec3 ave);
+    int isEdge(GBuffer& gbuffer, int i, int j);
+    void traceRegion(GBuffer& gbuffer, int div, int x0, int y0, Image* costs = nullptr);
+    glm::vec3 aliasing(float xp, float yp, float cellX, float cellY, int step, long& samplesLeft, int i, int j, int node);
+    long pixelSampleCap();
+    float edgeError(GBuffer& gbuffer, int i, int j);
+    void antiAliasTile(Tile& tile, Image& image, std::vector<EdgeCell>* deferred);
+    void previewTile(Tile& tile, Image& image);
+    void renderBudgeted(TileSink& sink);
+    void renderTiles(std::vector<Tile>& work, std::vector<int>& which, TileSink& sink, Checkpoint* checkpoint,
+                     int done, int total);
+    void runWorkers(int count, std::function<void(int)> fn);
+    int workerCount();
+    int isCancelled();
+    uint64_t settingsHash();
+
+public:
+    Renderer(Scene& scene, Camera camera, RenderSettings settings);
+
+    glm::vec3 trace(Ray ray, int step);
+    glm::vec3 shade(Ray ray, int step);
+    glm::vec3 aliasing(float xp, float yp, float cellX, float cellY, int step);
+    Ray primaryRay(float x, float y);
+
+    std::vector<Tile> tiles();
+    void renderTile(Tile& tile, Image& image, std::vector<EdgeCell>* deferred = nullptr, uint64_t* touched = nullptr);
+    void render(TileSink& sink);
+    Image render();
+    int rerender(TileSink& sink, const std::vector<int>& changed);
+};
+
+Image render(Scene& scene, Camera camera, RenderSettings settings);
+void render(Scene& scene, Camera camera, RenderSettings settings, TileSink& sink);
+int rerender(Scene& scene, Camera camera, RenderSettings settings, Image& image, const std::vector<int>& changed);
+
+#endif //!H_RENDERER
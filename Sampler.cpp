@@ -0,0 +1,258 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The sampler classes
+-------------------------------------------------------------*/
+
+#include "Sampler.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+const int MASK_SIZE = 64;           //Side of the blue-noise mask (a power of two)
+const float MASK_SIGMA = 1.5f;      //Width of the void-and-cluster filter, in mask cells
+
+//Mixes the bits of x
+static uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+//A different random value for each cell and salt
+static uint32_t hash(int i, int j, uint32_t salt)
+{
+    return hash((uint32_t)i * 0x9E3779B1u ^ hash((uint32_t)j + salt * 0x85EBCA6Bu));
+}
+
+//Maps 32 bits to [0, 1)
+static float toUnit(uint32_t x)
+{
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+static float fraction(float x)
+{
+    return x - floorf(x);
+}
+
+//Van der Corput sequence: the bits of i mirrored about the binary point
+static uint32_t reverseBits(uint32_t i)
+{
+    i = (i << 16) | (i >> 16);
+    i = ((i & 0x00FF00FFu) << 8) | ((i & 0xFF00FF00u) >> 8);
+    i = ((i & 0x0F0F0F0Fu) << 4) | ((i & 0xF0F0F0F0u) >> 4);
+    i = ((i & 0x33333333u) << 2) | ((i & 0xCCCCCCCCu) >> 2);
+    i = ((i & 0x55555555u) << 1) | ((i & 0xAAAAAAAAu) >> 1);
+    return i;
+}
+
+//Second dimension of the Sobol sequence
+static uint32_t sobol2(uint32_t i)
+{
+    uint32_t r = 0;
+    for (uint32_t v = 1u << 31; i; i >>= 1, v ^= v >> 1)
+        if (i & 1) r ^= v;
+    return r;
+}
+
+//Radical inverse of i in base 3
+static float halton3(uint32_t i)
+{
+    float result = 0, f = 1.0f / 3;
+    for (; i > 0; i /= 3, f /= 3) result += f * (i % 3);
+    return result;
+}
+
+//---Builds a blue-noise mask by void and cluster (Ulichney 1993) ----------------------
+//   Starting from a few random points, the point in the tightest cluster is moved to
+//     the largest void until that changes nothing.  The points are then ranked by
+//     removing the tightest clusters, and the rest of the mask by filling the largest
+//     voids.  Returns MASK_SIZE^2 values, each rank once, scaled to [0, 1).
+//----------------------------------------------------------------------------------
+static std::vector<float> voidAndCluster(uint32_t seed)
+{
+    const int n = MASK_SIZE * MASK_SIZE;
+    const int mask = MASK_SIZE - 1;
+
+    //Gaussian of the distance on the torus, by offset
+    std::vector<float> kernel(n);
+    for (int dy = 0; dy < MASK_SIZE; dy++)
+        for (int dx = 0; dx < MASK_SIZE; dx++)
+        {
+            int ex = std::min(dx, MASK_SIZE - dx);
+            int ey = std::min(dy, MASK_SIZE - dy);
+            kernel[dy * MASK_SIZE + dx] = expf(-(ex * ex + ey * ey) / (2 * MASK_SIGMA * MASK_SIGMA));
+        }
+
+    auto splat = [&](std::vector<float>& energy, int p, float sign)
+    {
+        int px = p % MASK_SIZE, py = p / MASK_SIZE;
+        for (int q = 0; q < n; q++)
+        {
+            int qx = q % MASK_SIZE, qy = q / MASK_SIZE;
+            energy[q] += sign * kernel[((qy - py) & mask) * MASK_SIZE + ((qx - px) & mask)];
+        }
+    };
+    auto tightestCluster = [&](std::vector<char>& pattern, std::vector<float>& energy)
+    {
+        int best = -1;
+        for (int p = 0; p < n; p++)
+            if (pattern[p] && (best < 0 || energy[p] > energy[best])) best = p;
+        return best;
+    };
+    auto largestVoid = [&](std::vector<char>& pattern, std::vector<float>& energy)
+    {
+        int best = -1;
+        for (int p = 0; p < n; p++)
+            if (!pattern[p] && (best < 0 || energy[p] < energy[best])) best = p;
+        return best;
+    };
+
+    std::vector<char> pattern(n, 0);
+    std::vector<float> energy(n, 0);
+    int ones = 0;
+    for (uint32_t h = seed; ones < n / 10; )
+    {
+        h = hash(h);
+        int p = h % n;
+        if (pattern[p]) continue;
+        pattern[p] = 1;
+        splat(energy, p, 1);
+        ones++;
+    }
+
+    for (int iteration = 0; iteration < n; iteration++)
+    {
+        int cluster = tightestCluster(pattern, energy);
+        pattern[cluster] = 0;
+        splat(energy, cluster, -1);
+        int gap = largestVoid(pattern, energy);
+        pattern[gap] = 1;
+        splat(energy, gap, 1);
+        if (gap == cluster) break;
+    }
+
+    std::vector<int> rank(n);
+    std::vector<char> removing = pattern;
+    std::vector<float> removingEnergy = energy;
+    for (int r = ones - 1; r >= 0; r--)
+    {
+        int cluster = tightestCluster(removing, removingEnergy);
+        removing[cluster] = 0;
+        splat(removingEnergy, cluster, -1);
+        rank[cluster] = r;
+    }
+    for (int r = ones; r < n; r++)
+    {
+        int gap = largestVoid(pattern, energy);
+        pattern[gap] = 1;
+        splat(energy, gap, 1);
+        rank[gap] = r;
+    }
+
+    std::vector<float> values(n);
+    for (int p = 0; p < n; p++) values[p] = (rank[p] + 0.5f) / n;
+    return values;
+}
+
+void RegularSampler::quad(int i, int j, int node, glm::vec2 points[4])
+{
+    points[0] = glm::vec2(0.25f, 0.25f);
+    points[1] = glm::vec2(0.75f, 0.25f);
+    points[2] = glm::vec2(0.25f, 0.75f);
+    points[3] = glm::vec2(0.75f, 0.75f);
+}
+
+void StratifiedSampler::quad(int i, int j, int node, glm::vec2 points[4])
+{
+    for (int q = 0; q < 4; q++)
+    {
+        uint32_t h = hash(i, j, node * 4 + q);
+        points[q] = 0.5f * glm::vec2((q & 1) + toUnit(h), (q >> 1) + toUnit(hash(h)));
+    }
+}
+
+/**
+* Successive Halton points fill the quadrants of successive nodes, all shifted
+* by one random offset per cell so that neighbouring cells do not correlate.
+*/
+void HaltonSampler::quad(int i, int j, int node, glm::vec2 points[4])
+{
+    float rx = toUnit(hash(i, j, 1)), ry = toUnit(hash(i, j, 2));
+    for (int q = 0; q < 4; q++)
+    {
+        uint32_t index = node * 4 + q + 1;
+        float u = fraction(toUnit(reverseBits(index)) + rx);
+        float v = fraction(halton3(index) + ry);
+        points[q] = 0.5f * glm::vec2((q & 1) + u, (q >> 1) + v);
+    }
+}
+
+/**
+* Each aligned block of four Sobol points has one point in each quadrant, which
+* random digit scrambling (one per cell) preserves.
+*/
+void SobolSampler::quad(int i, int j, int node, glm::vec2 points[4])
+{
+    uint32_t sx = hash(i, j, 1), sy = hash(i, j, 2);
+    for (int k = 0; k < 4; k++)
+    {
+        uint32_t index = node * 4 + k;
+        float u = toUnit(reverseBits(index) ^ sx);
+        float v = toUnit(sobol2(index) ^ sy);
+        int q = (u >= 0.5f) + 2 * (v >= 0.5f);
+        points[q] = glm::vec2(u, v);
+    }
+}
+
+/**
+* Sobol points shifted within their quadrant by the value of a blue-noise mask
+* tiled over the image.  Neighbouring cells get very different shifts, so the
+* error that is left looks like fine, even grain rather than patterns.
+*/
+void BlueNoiseSampler::quad(int i, int j, int node, glm::vec2 points[4])
+{
+    static const std::vector<float> maskX = voidAndCluster(363);
+    static const std::vector<float> maskY = voidAndCluster(2021);
+    int cell = (j & (MASK_SIZE - 1)) * MASK_SIZE + (i & (MASK_SIZE - 1));
+
+    for (int k = 0; k < 4; k++)
+    {
+        uint32_t index = node * 4 + k;
+        float u = toUnit(reverseBits(index));
+        float v = toUnit(sobol2(index));
+        int qx = (u >= 0.5f), qy = (v >= 0.5f);
+        float lu = fraction(2 * u - qx + maskX[cell]);
+        float lv = fraction(2 * v - qy + maskY[cell]);
+        points[qx + 2 * qy] = 0.5f * glm::vec2(qx + lu, qy + lv);
+    }
+}
+
+std::unique_ptr<Sampler> createSampler(SamplerType type)
+{
+    switch (type)
+    {
+        case SAMPLER_STRATIFIED: return std::unique_ptr<Sampler>(new StratifiedSampler());
+        case SAMPLER_HALTON: return std::unique_ptr<Sampler>(new HaltonSampler());
+        case SAMPLER_SOBOL: return std::unique_ptr<Sampler>(new SobolSampler());
+        case SAMPLER_BLUE_NOISE: return std::unique_ptr<Sampler>(new BlueNoiseSampler());
+        default: return std::unique_ptr<Sampler>(new RegularSampler());
+    }
+}
+
+const char* samplerName(SamplerType type)
+{
+    switch (type)
+    {
+        case SAMPLER_STRATIFIED: return "stratified";
+        case SAMPLER_HALTON: return "halton";
+        case SAMPLER_SOBOL: return "sobol";
+        case SAMPLER_BLUE_NOISE: return "bluenoise";
+        default: return "regular";
+    }
+}
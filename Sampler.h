@@ -0,0 +1,75 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The sampler classes
+*  Choose where the rays of adaptive anti-aliasing pass
+*  through a cell.  Each step of the subdivision traces
+*  one ray in each quadrant of a (sub)cell, so a sampler
+*  returns four points, one per quadrant, for every node
+*  of that quadtree.  Points depend only on the cell and
+*  the node, so renders are repeatable on any number of
+*  threads.
+-------------------------------------------------------------*/
+
+#ifndef H_SAMPLER
+#define H_SAMPLER
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+
+enum SamplerType
+{
+    SAMPLER_REGULAR,        //Centre of each quadrant: the original pattern
+    SAMPLER_STRATIFIED,     //Uniform random point in each quadrant
+    SAMPLER_HALTON,         //Halton (2, 3) points in each quadrant, shifted per cell
+    SAMPLER_SOBOL,          //Blocks of four scrambled Sobol points, one per quadrant
+    SAMPLER_BLUE_NOISE      //Sobol points shifted by a blue-noise mask over the image
+};
+
+class Sampler
+{
+public:
+    virtual ~Sampler() {}
+
+    /**
+     * Points for node 'node' of cell (i, j), in cell units: points[q] lies in
+     * quadrant q (bottom-left, bottom-right, top-left, top-right).  The root
+     * is node 0 and quadrant q of node n is node 4n+1+q.
+     */
+    virtual void quad(int i, int j, int node, glm::vec2 points[4]) = 0;
+};
+
+class RegularSampler : public Sampler
+{
+public:
+    void quad(int i, int j, int node, glm::vec2 points[4]);
+};
+
+class StratifiedSampler : public Sampler
+{
+public:
+    void quad(int i, int j, int node, glm::vec2 points[4]);
+};
+
+class HaltonSampler : public Sampler
+{
+public:
+    void quad(int i, int j, int node, glm::vec2 points[4]);
+};
+
+class SobolSampler : public Sampler
+{
+public:
+    void quad(int i, int j, int node, glm::vec2 points[4]);
+};
+
+class BlueNoiseSampler : public Sampler
+{
+public:
+    void quad(int i, int j, int node, glm::vec2 points[4]);
+};
+
+std::unique_ptr<Sampler> createSampler(SamplerType type);
+const char* samplerName(SamplerType type);
+
+#endif //!H_SAMPLER
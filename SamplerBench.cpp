@@ -0,0 +1,80 @@
+/*==================================================================================
+* COSC 363  Computer Graphics
+* Department of Computer Science and Software Engineering, University of Canterbury.
+*
+* Sampler benchmark
+* Measures the anti-aliasing error of each sampler against the number of rays per
+* pixel.  Every pixel of the default scene is subdivided to the same depth, so a
+* pixel averages 4^depth rays, and the result is compared with a reference image
+* of 4^REFERENCE_DEPTH stratified rays per pixel.  Prints the RMS error, which can
+* be used to pick the sampler and sample count reaching a given quality cheapest.
+*
+* Usage:  SamplerBench.out [resolution] [max depth]
+*===================================================================================
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include "Renderer.h"
+using namespace std;
+
+const int REFERENCE_DEPTH = 6;
+
+//Settings that subdivide every pixel to 'depth' levels
+static RenderSettings uniformSettings(int resolution, int depth, SamplerType sampler)
+{
+    RenderSettings settings;
+    settings.resolution = resolution;
+    settings.antiAliasing = true;
+    settings.maxAliasSteps = depth;
+    settings.colDiff = -1;          //Every colour counts as distinct
+    settings.sampler = sampler;
+    return settings;
+}
+
+static double rmsError(Image& image, Image& reference)
+{
+    double sum = 0;
+    for (int j = 0; j < image.getHeight(); j++)
+        for (int i = 0; i < image.getWidth(); i++)
+        {
+            glm::vec3 d = glm::clamp(image.at(i, j), 0.0f, 1.0f) - glm::clamp(reference.at(i, j), 0.0f, 1.0f);
+            sum += glm::dot(d, d) / 3;
+        }
+    return sqrt(sum / (image.getWidth() * image.getHeight()));
+}
+
+int main(int argc, char* argv[])
+{
+    int resolution = (argc > 1) ? atoi(argv[1]) : 64;
+    int maxDepth = (argc > 2) ? atoi(argv[2]) : 4;
+
+    shared_ptr<Scene> scene = createDefaultScene();
+    Camera camera;
+
+    cout << "Reference: " << resolution << "x" << resolution << ", "
+         << (1 << (2 * REFERENCE_DEPTH)) << " stratified rays per pixel" << endl;
+    Image reference = render(*scene, camera, uniformSettings(resolution, REFERENCE_DEPTH, SAMPLER_STRATIFIED));
+
+    cout << left << setw(12) << "sampler";
+    for (int depth = 1; depth <= maxDepth; depth++) cout << right << setw(10) << (1 << (2 * depth));
+    cout << setw(10) << "ms" << endl;
+
+    SamplerType types[] = {SAMPLER_REGULAR, SAMPLER_STRATIFIED, SAMPLER_HALTON, SAMPLER_SOBOL, SAMPLER_BLUE_NOISE};
+    for (SamplerType type : types)
+    {
+        cout << left << setw(12) << samplerName(type) << right << fixed << setprecision(5);
+        double millis = 0;
+        for (int depth = 1; depth <= maxDepth; depth++)
+        {
+            auto start = chrono::steady_clock::now();
+            Image image = render(*scene, camera, uniformSettings(resolution, depth, type));
+            millis += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            cout << setw(10) << rmsError(image, reference) << flush;
+        }
+        cout << setw(10) << setprecision(0) << millis << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene class
+-------------------------------------------------------------*/
+
+#include "Scene.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Cylinder.h"
+#include "Cone.h"
+#include "MappedMesh.h"
+#include "Checkpoint.h"
+#include <cstdlib>
+#include <random>
+
+Scene::Scene() : bvh_(std::make_shared<BVH>())
+{
+}
+
+/**
+* Adds an object to the scene, which takes ownership of it.
+* Returns the object's index.
+*/
+int Scene::add(SceneObject* obj)
+{
+    owned_.push_back(std::shared_ptr<SceneObject>(obj));
+    objects.push_back(obj);
+    return (int)objects.size() - 1;
+}
+
+/**
+* Puts obj in the place of object 'index', taking ownership of it.  Copies of
+* the scene keep the old object.  If obj's box differs from the old one's, the
+* scene tests objects one by one until the BVH is rebuilt.
+*/
+void Scene::replace(int index, SceneObject* obj)
+{
+    glm::vec3 lo, hi, newLo, newHi;
+    objects[index]->bounds(lo, hi);
+    obj->bounds(newLo, newHi);
+    owned_[index] = std::shared_ptr<SceneObject>(obj);
+    objects[index] = obj;
+    if (lo != newLo || hi != newHi) bvh_ = std::make_shared<BVH>();
+}
+
+//Keeps a material alive for as long as the scene
+Material* Scene::addMaterial(Material* mat)
+{
+    materials_.push_back(std::shared_ptr<Material>(mat));
+    return mat;
+}
+
+//Loads a texture that lives as long as the scene
+TextureBMP* Scene::loadTexture(const char* filename)
+{
+    textures_.push_back(std::make_shared<TextureBMP>(filename));
+    return textures_.back().get();
+}
+
+/**
+* Builds a BVH over the objects added so far.  Adding objects later makes the
+* scene fall back to testing every object until the BVH is rebuilt.
+*/
+void Scene::buildBVH(BVHBuild method, int threads, int treeletPasses)
+{
+    std::shared_ptr<BVH> bvh = std::make_shared<BVH>();     //Copies of the scene keep the old tree
+    bvh->build(objects, method, threads, treeletPasses);
+    bvh_ = bvh;
+}
+
+BVHStats Scene::getBVHStats()
+{
+    return bvh_->getStats();
+}
+
+/**
+* Finds the closest point of intersection of a ray with the scene's objects,
+* ignoring any at maxDist or beyond.  Returns the number of ray-object
+* intersection tests made.
+*/
+int Scene::closestPt(Ray& ray, float maxDist)
+{
+    if (bvh_->isCurrent((int)objects.size())) return bvh_->closestPt(ray, objects, maxDist);
+    ray.closestPt(objects);
+    if (ray.dist >= maxDist) ray.index = -1;
+    return (int)objects.size();
+}
+
+//---Fingerprint of everything a render reads ----------------------------------------
+//   Covers the light, the background and each object's box and surface properties.
+//     Three probe rays through each box add the distance, normal and colour of
+//     their hits, standing in for the object's shape and texture.
+//----------------------------------------------------------------------------------
+uint64_t Scene::hash()
+{
+    Fingerprint print;
+    print.add(lightPos);
+    print.add(lightShape.type);
+    print.add(lightShape.edgeU);
+    print.add(lightShape.edgeV);
+    print.add(lightShape.radius);
+    print.add(backgroundCol);
+    print.add(objects.size());
+
+    for (SceneObject* obj : objects)
+    {
+        glm::vec3 lo, hi;
+        obj->bounds(lo, hi);
+        print.add(lo);
+        print.add(hi);
+        print.add(obj->getColor());
+        int flags = obj->isReflective() + 2 * obj->isRefractive() + 4 * obj->isSpecular() + 8 * obj->isTransparent();
+        print.add(flags);
+        float coeffs[5] = {obj->getReflectionCoeff(), obj->getRefractionCoeff(), obj->getTransparencyCoeff(),
+                           obj->getRefractiveIndex(), obj->getShininess()};
+        print.add(coeffs);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            glm::vec3 dir(0.2f);
+            dir[axis] = 1;
+            dir = glm::normalize(dir);
+            glm::vec3 p0 = 0.5f * (lo + hi) - dir * (glm::length(hi - lo) + 1);
+            float t = obj->intersect(p0, dir);
+            print.add(t);
+            if (t <= 0) continue;
+            glm::vec3 hit = p0 + dir * t;
+            print.add(obj->normal(hit));
+            print.add(obj->getColor(hit));
+        }
+    }
+    return print.value();
+}
+
+//---Creates the assignment scene ---------------------------------------------------
+//   A checkered floor, a textured sphere, a pyramid, refractive, reflective
+//   and transparent spheres, two cylinders and two cones.
+//----------------------------------------------------------------------------------
+std::shared_ptr<Scene> createDefaultScene()
+{
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+
+    TextureBMP* texture = scene->loadTexture("Butterfly.bmp");
+
+    Plane *plane = new Plane(glm::vec3(-200., -15, -30),
+                             glm::vec3(200., -15, -30),
+                             glm::vec3(200., -15, -200),
+                             glm::vec3(-200., -15, -200));
+
+
+    plane->setSpecularity(false);
+    plane->setMaterial(scene->addMaterial(new CheckerMaterial(glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), 5)));
+    scene->add(plane);
+
+    // Textured Sphere
+    Sphere *texturedSphere = new Sphere(glm::vec3(6, -4, -55), 3.0);
+    //texturedSphere->setShininess(5);
+    texturedSphere->setMaterial(scene->addMaterial(new TextureMaterial(texture)));
+    scene->add(texturedSphere);
+
+
+    glm::vec3 A(-10, -15, -45);
+    glm::vec3 B(0, -15, -35);
+    glm::vec3 C(0, -5, -37.5);
+    glm::vec3 D(10, -15, -45);
+    glm::vec3 E(0, -15, -55);
+
+
+    Plane *triangle1 = new Plane(A, B, C);
+    Plane *triangle2 = new Plane(B, D, C);
+    Plane *triangle3 = new Plane(D, E, C);
+    Plane *triangle4 = new Plane(E, A, C);
+
+
+    triangle1->setColor(glm::vec3(0, 0, 1));
+    triangle2->setColor(glm::vec3(0, 0, 1));
+    triangle3->setColor(glm::vec3(0, 0, 1));
+    triangle4->setColor(glm::vec3(0, 0, 1));
+    scene->add(triangle1);
+    scene->add(triangle2);
+    scene->add(triangle3);
+    scene->add(triangle4);
+
+
+    //Refractive Sphere
+    Sphere *sphere1 = new Sphere(glm::vec3(0, 0, -37), 5.0);
+    sphere1->setColor(glm::vec3(1, 1, 0));
+    sphere1->setRefractivity(true, 0.76, 1.01);
+    sphere1->setReflectivity(true, 0.2);
+
+    sphere1->setShininess(20);
+    scene->add(sphere1);		 //Add sphere to scene objects
+
+    //Red Sphere
+    Sphere *sphere2 = new Sphere(glm::vec3(5, 10, -100), 4.0);
+    sphere2->setColor(glm::vec3(1, 0, 0));
+    sphere2->setShininess(5);
+    scene->add(sphere2);
+
+    //Reflective Sphere
+    Sphere *sphere3 = new Sphere(glm::vec3(-5, 0, -60), 5.0);
+    sphere3->setColor(glm::vec3(0, 0, 0));
+    sphere3->setShininess(5);
+    sphere3->setReflectivity(true, 0.8);
+    scene->add(sphere3);
+
+    Sphere *sphere4 = new Sphere(glm::vec3(20, -5, -50), 4.25);
+    sphere4->setTransparency(true, 0.5);
+    sphere4->setColor(glm::vec3(0.4, 0.4, 0.8));
+    sphere4->setReflectivity(true, 0.2);
+    scene->add(sphere4);
+
+    Cylinder *cylinder1 = new Cylinder(glm::vec3(20, -15, -50), 2.5, 5, true);
+    cylinder1->setColor(glm::vec3(0, 0, 1));
+    scene->add(cylinder1);
+
+    Sphere *sphere6 = new Sphere(glm::vec3(-20, -5, -50), 4.25);
+    sphere6->setTransparency(true, 0.5);
+    sphere6->setColor(glm::vec3(0.4, 0.4, 0.8));
+    sphere6->setReflectivity(true, 0.2);
+    scene->add(sphere6);
+
+    Cylinder *cylinder2 = new Cylinder(glm::vec3(-20, -15, -50), 2.5, 5, true);
+    cylinder2->setColor(glm::vec3(0, 0, 1));
+    scene->add(cylinder2);
+
+    Cone *cone1 = new Cone(glm::vec3(40, -15, -100), 2, 10);
+    cone1->setColor(glm::vec3(1, 0, 0));
+    scene->add(cone1);
+
+    Cone *cone2 = new Cone(glm::vec3(-40, -15, -100), 2, 10);
+    cone2->setColor(glm::vec3(1, 0, 0));
+    scene->add(cone2);
+
+    return scene;
+}
+
+//---Creates a scene of random objects ---------------------------------------------
+//   Spheres, triangles, cylinders and cones in the ratio 4:2:1:1 fill a cube in
+//     front of the default camera, sized so that it is roughly half full whatever
+//     their number.  Each object is reflective, refractive and transparent with
+//     the given probabilities.  The same parameters give the same scene.
+//----------------------------------------------------------------------------------
+std::shared_ptr<Scene> createStressScene(const StressSceneParams& params)
+{
+    const float BOX_SIZE = 160;                 //Fills the view, short of full fog
+    const glm::vec3 BOX_CENTRE(0, 0, -110);
+
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+    std::mt19937 rng(params.seed);
+    std::uniform_real_distribution<float> unit(0, 1);
+    float size = BOX_SIZE / cbrtf((float)std::max(params.objects, 1L)) * 0.4f;
+
+    for (long i = 0; i < params.objects; i++)
+    {
+        glm::vec3 c = BOX_CENTRE + BOX_SIZE * glm::vec3(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f);
+        float r = size * (0.25f + unit(rng));
+        SceneObject* obj;
+        switch (i % 8)
+        {
+        case 0:
+            obj = new Cylinder(c, r * 0.5f, r, true);
+            break;
+        case 1:
+            obj = new Cone(c, r * 0.5f, r);
+            break;
+        case 2:
+        case 3:
+            obj = new Plane(c, c + glm::vec3(r, 0, 0), c + glm::vec3(0, r, r));
+            break;
+        default:
+            obj = new Sphere(c, r * 0.5f);
+        }
+        obj->setColor(glm::vec3(unit(rng), unit(rng), unit(rng)));
+        if (unit(rng) < params.reflective) obj->setReflectivity(true, 0.5f);
+        if (unit(rng) < params.refractive) obj->setRefractivity(true, 0.8f, 1.3f);
+        if (unit(rng) < params.transparent) obj->setTransparency(true, 0.5f);
+        scene->add(obj);
+    }
+    return scene;
+}
+
+/**
+* Creates a scene by name, with its BVH built, or returns null if there is
+* no such scene.  Known scenes: "default", and "softshadows" and "spherelight",
+* the default scene lit by a 10x10 square light and a sphere light of radius 5;
+* "stress-<n>" is a stress scene of n objects with the default fractions;
+* "mesh:<file>" is the mesh file (see MappedMesh) alone, paged within the
+* default budget.
+*/
+std::shared_ptr<Scene> loadScene(const std::string& name)
+{
+    std::shared_ptr<Scene> scene;
+    if (name == "default") scene = createDefaultScene();
+    if (name == "softshadows")
+    {
+        scene = createDefaultScene();
+        scene->lightShape.type = LIGHT_RECT;
+        scene->lightShape.edgeU = glm::vec3(10, 0, 0);
+        scene->lightShape.edgeV = glm::vec3(0, 0, 10);
+    }
+    if (name == "spherelight")
+    {
+        scene = createDefaultScene();
+        scene->lightShape.type = LIGHT_SPHERE;
+        scene->lightShape.radius = 5;
+    }
+    if (name.compare(0, 7, "stress-") == 0 && atol(name.c_str() + 7) > 0)
+    {
+        StressSceneParams params;
+        params.objects = atol(name.c_str() + 7);
+        scene = createStressScene(params);
+    }
+    if (name.compare(0, 5, "mesh:") == 0)
+    {
+        MappedMesh* mesh = new MappedMesh();
+        if (mesh->open(name.c_str() + 5))
+        {
+            scene = std::make_shared<Scene>();
+            mesh->setColor(glm::vec3(0.7f));
+            scene->add(mesh);
+        }
+        else delete mesh;
+    }
+    if (scene != nullptr) scene->buildBVH(BVH_SAH);   //Loaded scenes are kept, so take the better tree
+    return scene;
+}
@@ -0,0 +1,73 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene class
+*  Holds everything a render reads: the objects, the
+*  materials and textures they use, and the light.  The
+*  scene owns all of them, so several scenes can be built
+*  and rendered side by side in one process.  Rays are
+*  compared with the objects through a BVH once one has
+*  been built, and one by one until then.  A copy of a
+*  scene shares all of these with it; replace() and
+*  buildBVH() change only the copy (see SceneVersions).
+-------------------------------------------------------------*/
+
+#ifndef H_SCENE
+#define H_SCENE
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "SceneObject.h"
+#include "BVH.h"
+#include "Ray.h"
+#include "Material.h"
+#include "TextureBMP.h"
+#include "Light.h"
+
+class Scene
+{
+private:
+    std::vector<std::shared_ptr<SceneObject>> owned_;
+    std::vector<std::shared_ptr<Material>> materials_;
+    std::vector<std::shared_ptr<TextureBMP>> textures_;
+    std::shared_ptr<BVH> bvh_;                          //Shared by copies until one of them rebuilds it
+
+public:
+    std::vector<SceneObject*> objects;                  //Objects in index order (Ray::index)
+    glm::vec3 lightPos = glm::vec3(30, 40, 20);         //Light's position (its centre if it has a shape)
+    LightShape lightShape;                              //A point unless set
+    glm::vec3 backgroundCol = glm::vec3(0.8, 0.8, 0.8);
+
+    Scene();
+
+    int add(SceneObject* obj);
+    void replace(int index, SceneObject* obj);
+    Material* addMaterial(Material* mat);
+    TextureBMP* loadTexture(const char* filename);
+
+    void buildBVH(BVHBuild method, int threads = 0, int treeletPasses = 0);
+    BVHStats getBVHStats();
+    int closestPt(Ray& ray, float maxDist = 1.e+6);
+    uint64_t hash();
+};
+
+/**
+ * A scene of random objects for stress tests (see createStressScene()).
+ * The fractions are of all objects, chosen independently.
+ */
+struct StressSceneParams
+{
+    long objects = 1000;
+    float reflective = 0.1f;
+    float refractive = 0.05f;
+    float transparent = 0.05f;
+    unsigned seed = 363;
+};
+
+std::shared_ptr<Scene> createDefaultScene();
+std::shared_ptr<Scene> createStressScene(const StressSceneParams& params);
+std::shared_ptr<Scene> loadScene(const std::string& name);
+
+#endif //!H_SCENE
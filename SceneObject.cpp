@@ -8,17 +8,60 @@
 -------------------------------------------------------------*/
 
 #include "SceneObject.h"
+#include "Material.h"
 
 glm::vec3 SceneObject::getColor()
 {
 	return color_;
 }
 
+//Colour of the surface at the point 'hit', given by the material if there is one
+glm::vec3 SceneObject::getColor(glm::vec3 hit)
+{
+	if (mat_ != nullptr) return mat_->colorAt(this, hit);
+	return color_;
+}
+
+Material* SceneObject::getMaterial()
+{
+	return mat_;
+}
+
+/**
+* Distances along the ray (p0, dir) at which it enters and leaves the solid
+* bounded by a closed object; tEntry is negative if p0 is inside.  Returns
+* false if the ray misses the object or the object is not closed, as for
+* planes, which is the default.
+*/
+bool SceneObject::interval(glm::vec3 p0, glm::vec3 dir, float& tEntry, float& tExit)
+{
+	return false;
+}
+
+/**
+* A new copy of the object, sharing its material, for a scene version to
+* change (see SceneVersions).  Null, the default, if it cannot be copied.
+*/
+SceneObject* SceneObject::clone()
+{
+	return nullptr;
+}
+
+/**
+* Describes the object as a quadric, for testing rays against several at once,
+* and returns true; or returns false, the default, if it is not one.
+*/
+bool SceneObject::quadric(Quadric& q)
+{
+	return false;
+}
+
 glm::vec3 SceneObject::lighting(glm::vec3 lightPos, glm::vec3 viewVec, glm::vec3 hit)
 {
 	float ambientTerm = 0.2;
 	float diffuseTerm = 0;
 	float specularTerm = 0;
+	glm::vec3 color = getColor(hit);
 	glm::vec3 normalVec = normal(hit);
 	glm::vec3 lightVec = lightPos - hit;
 	lightVec = glm::normalize(lightVec);
@@ -29,7 +72,7 @@ glm::vec3 SceneObject::lighting(glm::vec3 lightPos, glm::vec3 viewVec, glm::vec3
 		float rDotv = glm::dot(reflVec, viewVec);
 		if (rDotv > 0) specularTerm = pow(rDotv, shin_);
 	}
-	glm::vec3 colorSum = ambientTerm * color_ + lDotn * color_ + specularTerm * glm::vec3(1);
+	glm::vec3 colorSum = ambientTerm * color + lDotn * color + specularTerm * glm::vec3(1);
 	return colorSum;
 }
 
@@ -85,6 +128,11 @@ void SceneObject::setColor(glm::vec3 col)
 	color_ = col;
 }
 
+void SceneObject::setMaterial(Material* mat)
+{
+	mat_ = mat;
+}
+
 void SceneObject::setReflectivity(bool flag)
 {
 	refl_ = flag;
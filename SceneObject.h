@@ -7,13 +7,15 @@
 *  Being an abstract class, this class cannot be instantiated.
 *  Sphere, Plane etc, must be defined as subclasses of Object
 *      and provide implementations for the virtual functions
-*      intersect()  and normal().
+*      intersect(), normal() and bounds().
 -------------------------------------------------------------*/
 
 #ifndef H_SOBJECT
 #define H_SOBJECT
 #include <glm/glm.hpp>
 
+class Material;
+struct Quadric;
 
 class SceneObject 
 {
@@ -28,14 +30,20 @@ protected:
 	float tranc_ = 0.8;  //coefficient of transparency
 	float refri_ = 1.0;  //refractive index
 	float shin_ = 50.0; //shininess
+	Material* mat_ = nullptr;  //colour source evaluated per hit; color_ is used if null
 public:
 	SceneObject() {}
     virtual float intersect(glm::vec3 p0, glm::vec3 dir) = 0;
 	virtual glm::vec3 normal(glm::vec3 pos) = 0;
+	virtual void bounds(glm::vec3& lo, glm::vec3& hi) = 0;   //Axis-aligned box holding every hit
+	virtual bool interval(glm::vec3 p0, glm::vec3 dir, float& tEntry, float& tExit);   //Span of a ray inside a closed object
+	virtual SceneObject* clone();   //Copy to edit in a new scene version; null if the object cannot be copied
+	virtual bool quadric(Quadric& q);   //The object as a quadric, if it is one (see Quadric.h)
 	virtual ~SceneObject() {}
 
 	glm::vec3 lighting(glm::vec3 lightPos, glm::vec3 viewVec, glm::vec3 hit);
 	void setColor(glm::vec3 col);
+	void setMaterial(Material* mat);
 	void setReflectivity(bool flag);
 	void setReflectivity(bool flag, float refl_coeff);
 	void setRefractivity(bool flag);
@@ -45,6 +53,8 @@ public:
 	void setTransparency(bool flag);
 	void setTransparency(bool flag, float tran_coeff);
 	glm::vec3 getColor();
+	glm::vec3 getColor(glm::vec3 hit);
+	Material* getMaterial();
 	float getReflectionCoeff();
 	float getRefractionCoeff();
 	float getTransparencyCoeff();
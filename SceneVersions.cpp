@@ -0,0 +1,146 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene versions class
+-------------------------------------------------------------*/
+
+#include "SceneVersions.h"
+#include <thread>
+
+SceneSnapshot::SceneSnapshot(SceneSnapshot&& other)
+{
+    *this = std::move(other);
+}
+
+SceneSnapshot& SceneSnapshot::operator=(SceneSnapshot&& other)
+{
+    if (this != &other)
+    {
+        release();
+        versions_ = other.versions_;
+        slot_ = other.slot_;
+        scene_ = other.scene_;
+        version_ = other.version_;
+        other.versions_ = nullptr;
+        other.slot_ = -1;
+        other.scene_ = nullptr;
+    }
+    return *this;
+}
+
+SceneSnapshot::~SceneSnapshot()
+{
+    release();
+}
+
+//Unpins the version; the scene may be deleted from now on
+void SceneSnapshot::release()
+{
+    if (versions_ != nullptr) versions_->unpin(slot_);
+    versions_ = nullptr;
+    slot_ = -1;
+    scene_ = nullptr;
+}
+
+//The first version is the given scene, which must not be changed from now on
+SceneVersions::SceneVersions(std::shared_ptr<Scene> scene) : epoch_(1)
+{
+    for (std::atomic<uint64_t>& pin : pins_) pin.store(0);
+    current_.store(new Version{scene, 1, 0});
+}
+
+//No snapshot may outlive the versions
+SceneVersions::~SceneVersions()
+{
+    for (Version* v : retired_) delete v;
+    delete current_.load();
+}
+
+//---Pins the current version ------------------------------------------------------
+//   Takes a free reader slot and records the epoch in it before reading the
+//     current version, so a publish that retires the version after this point
+//     sees the pin.  Never blocks on edits; waits only while all
+//     MAX_SCENE_READERS slots are taken.
+//----------------------------------------------------------------------------------
+SceneSnapshot SceneVersions::pin()
+{
+    SceneSnapshot snapshot;
+    for (int slot = 0;; slot = (slot + 1) % MAX_SCENE_READERS)
+    {
+        uint64_t free = 0;
+        if (pins_[slot].compare_exchange_strong(free, epoch_.load()))
+        {
+            snapshot.slot_ = slot;
+            break;
+        }
+        if (slot == MAX_SCENE_READERS - 1) std::this_thread::yield();
+    }
+    Version* v = current_.load();
+    snapshot.versions_ = this;
+    snapshot.scene_ = v->scene.get();
+    snapshot.version_ = v->number;
+    return snapshot;
+}
+
+void SceneVersions::unpin(int slot)
+{
+    pins_[slot].store(0);
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);   //Readers never wait for an edit
+    if (lock.owns_lock()) reclaim();
+}
+
+//Deletes the retired versions no pin can still see (mutex_ must be held)
+void SceneVersions::reclaim()
+{
+    uint64_t oldest = UINT64_MAX;
+    for (std::atomic<uint64_t>& pin : pins_)
+    {
+        uint64_t e = pin.load();
+        if (e != 0 && e < oldest) oldest = e;
+    }
+    for (size_t k = 0; k < retired_.size(); )
+    {
+        if (retired_[k]->retired <= oldest)
+        {
+            delete retired_[k];
+            retired_[k] = retired_.back();
+            retired_.pop_back();
+        }
+        else k++;
+    }
+}
+
+//---Publishes a changed copy of the current version -------------------------------
+//   change() edits a copy of the scene, which shares everything with it: it
+//     replaces the objects it changes with clones (see Scene::replace()), and
+//     rebuilds the BVH if it moves any.  Returns the new version's number, or 0
+//     if change() returns false, when nothing is published.  Renders already
+//     running keep the version they pinned.
+//----------------------------------------------------------------------------------
+uint64_t SceneVersions::edit(const std::function<bool(Scene&)>& change)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Version* old = current_.load();
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>(*old->scene);
+    if (!change(*scene)) return 0;
+
+    Version* v = new Version{scene, old->number + 1, 0};
+    current_.store(v);
+    old->retired = epoch_.fetch_add(1) + 1;         //Pins from this epoch on read v
+    retired_.push_back(old);
+    reclaim();
+    return v->number;
+}
+
+uint64_t SceneVersions::version()
+{
+    return current_.load()->number;
+}
+
+//Versions replaced but still pinned by some render
+int SceneVersions::retiredCount()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    reclaim();
+    return (int)retired_.size();
+}
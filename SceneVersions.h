@@ -0,0 +1,92 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene versions class
+*  Publishes a scene as a sequence of immutable versions,
+*  so that it can be edited while renders of it run.  A
+*  render pins the current version for as long as it needs
+*  it and reads it without locks; an edit changes a copy,
+*  which shares every object, material, texture and the BVH
+*  it does not replace, then makes the copy current.  Old
+*  versions are deleted by epochs: each pin records the
+*  epoch it began in, every publish starts a new epoch, and
+*  a version retired in epoch e goes once no pin older than
+*  e is left.
+-------------------------------------------------------------*/
+
+#ifndef H_SCENEVERSIONS
+#define H_SCENEVERSIONS
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Scene.h"
+
+const int MAX_SCENE_READERS = 64;       //Versions pinned at once; more wait for one to be released
+
+class SceneVersions;
+
+/**
+ * A pinned scene version.  The scene must not be changed, and stays valid
+ * until the snapshot is released or destroyed.
+ */
+class SceneSnapshot
+{
+private:
+    SceneVersions* versions_ = nullptr;
+    int slot_ = -1;
+    Scene* scene_ = nullptr;
+    uint64_t version_ = 0;
+
+    friend class SceneVersions;
+
+public:
+    SceneSnapshot() = default;
+    SceneSnapshot(SceneSnapshot&& other);
+    SceneSnapshot& operator=(SceneSnapshot&& other);
+    ~SceneSnapshot();
+
+    SceneSnapshot(const SceneSnapshot&) = delete;
+    SceneSnapshot& operator=(const SceneSnapshot&) = delete;
+
+    Scene* scene() { return scene_; }
+    uint64_t version() { return version_; }
+    void release();
+};
+
+class SceneVersions
+{
+private:
+    struct Version
+    {
+        std::shared_ptr<Scene> scene;
+        uint64_t number;
+        uint64_t retired;                               //Epoch in which it stopped being current
+    };
+
+    std::atomic<Version*> current_;
+    std::atomic<uint64_t> epoch_;
+    std::atomic<uint64_t> pins_[MAX_SCENE_READERS];     //Epoch each reader pinned in; 0 if free
+    std::mutex mutex_;                                  //Serialises edits and guards retired_
+    std::vector<Version*> retired_;
+
+    void reclaim();
+    void unpin(int slot);
+    friend class SceneSnapshot;
+
+public:
+    SceneVersions(std::shared_ptr<Scene> scene);
+    ~SceneVersions();
+
+    SceneVersions(const SceneVersions&) = delete;
+    SceneVersions& operator=(const SceneVersions&) = delete;
+
+    SceneSnapshot pin();
+    uint64_t edit(const std::function<bool(Scene&)>& change);
+    uint64_t version();
+    int retiredCount();
+};
+
+#endif //!H_SCENEVERSIONS
@@ -0,0 +1,173 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Batched Phong shading
+*  Results match SceneObject::lighting() to within float
+*  rounding: the specular power is computed by repeated
+*  squaring for integer shininess values up to 255 (which
+*  covers every material in the scene), and by pow() for
+*  any other value.
+-------------------------------------------------------------*/
+
+#include "Shading.h"
+#include <math.h>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const float AMBIENT_TERM = 0.2f;   //Same ambient term as SceneObject::lighting()
+const int MAX_INT_SHININESS = 255;
+
+const int CHUNK = 64;              //Hits converted to structure-of-arrays form at a time
+
+/**
+* Structure-of-arrays copy of up to CHUNK hits.  Unused lanes of
+* the last group of four are zeroed, with a point one unit from
+* the light, so everything computed in them stays finite.
+*/
+struct HitBatch
+{
+    alignas(16) float px[CHUNK], py[CHUNK], pz[CHUNK];
+    alignas(16) float nx[CHUNK], ny[CHUNK], nz[CHUNK];
+    alignas(16) float vx[CHUNK], vy[CHUNK], vz[CHUNK];
+    alignas(16) float cr[CHUNK], cg[CHUNK], cb[CHUNK];
+    alignas(16) float shin[CHUNK];      //Shininess, or 0 for non-specular surfaces
+    alignas(16) int expo[CHUNK];        //Integer shininess, or 0 if pow() is needed
+    alignas(16) float r[CHUNK], g[CHUNK], b[CHUNK];
+    int maxExpo;
+};
+
+/**
+* Scalar Phong terms of one hit, used for lanes that need pow().
+*/
+static void shadeScalar(glm::vec3 lightPos, HitBatch& b, int k)
+{
+    glm::vec3 n(b.nx[k], b.ny[k], b.nz[k]);
+    glm::vec3 lightVec = glm::normalize(lightPos - glm::vec3(b.px[k], b.py[k], b.pz[k]));
+    float lDotn = glm::dot(lightVec, n);
+    float specularTerm = 0;
+    if (b.shin[k] > 0)
+    {
+        glm::vec3 reflVec = glm::reflect(-lightVec, n);
+        float rDotv = glm::dot(reflVec, glm::vec3(b.vx[k], b.vy[k], b.vz[k]));
+        if (rDotv > 0) specularTerm = pow(rDotv, b.shin[k]);
+    }
+    b.r[k] = (AMBIENT_TERM + lDotn) * b.cr[k] + specularTerm;
+    b.g[k] = (AMBIENT_TERM + lDotn) * b.cg[k] + specularTerm;
+    b.b[k] = (AMBIENT_TERM + lDotn) * b.cb[k] + specularTerm;
+}
+
+#if defined(__SSE2__)
+/**
+* Phong terms of the four hits starting at k.  Lanes whose exponent
+* is not a small integer are left for shadeScalar().
+*/
+static void shadeFour(__m128 lx, __m128 ly, __m128 lz, HitBatch& b, int k)
+{
+    __m128 ldx = _mm_sub_ps(lx, _mm_load_ps(&b.px[k]));
+    __m128 ldy = _mm_sub_ps(ly, _mm_load_ps(&b.py[k]));
+    __m128 ldz = _mm_sub_ps(lz, _mm_load_ps(&b.pz[k]));
+    __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ldx, ldx), _mm_mul_ps(ldy, ldy)), _mm_mul_ps(ldz, ldz)));
+    ldx = _mm_div_ps(ldx, len);
+    ldy = _mm_div_ps(ldy, len);
+    ldz = _mm_div_ps(ldz, len);
+
+    __m128 nx = _mm_load_ps(&b.nx[k]);
+    __m128 ny = _mm_load_ps(&b.ny[k]);
+    __m128 nz = _mm_load_ps(&b.nz[k]);
+    __m128 lDotn = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ldx, nx), _mm_mul_ps(ldy, ny)), _mm_mul_ps(ldz, nz));
+
+    //reflect(-l, n) = 2(l.n)n - l
+    __m128 twoLDotn = _mm_add_ps(lDotn, lDotn);
+    __m128 rx = _mm_sub_ps(_mm_mul_ps(twoLDotn, nx), ldx);
+    __m128 ry = _mm_sub_ps(_mm_mul_ps(twoLDotn, ny), ldy);
+    __m128 rz = _mm_sub_ps(_mm_mul_ps(twoLDotn, nz), ldz);
+    __m128 rDotv = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, _mm_load_ps(&b.vx[k])), _mm_mul_ps(ry, _mm_load_ps(&b.vy[k]))),
+                              _mm_mul_ps(rz, _mm_load_ps(&b.vz[k])));
+    rDotv = _mm_max_ps(rDotv, _mm_setzero_ps());
+
+    //rDotv^expo by repeated squaring over the bits of the exponent
+    __m128i expo = _mm_load_si128((const __m128i*)&b.expo[k]);
+    __m128 spec = _mm_set1_ps(1.0f);
+    __m128 base = rDotv;
+    for (int bit = 1; bit <= b.maxExpo; bit <<= 1)
+    {
+        __m128 useBit = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(expo, _mm_set1_epi32(bit)), _mm_set1_epi32(bit)));
+        spec = _mm_or_ps(_mm_and_ps(useBit, _mm_mul_ps(spec, base)), _mm_andnot_ps(useBit, spec));
+        base = _mm_mul_ps(base, base);
+    }
+    //No specular term for non-specular surfaces or when r.v <= 0
+    __m128 hasSpec = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(expo, _mm_setzero_si128())),
+                                _mm_cmpgt_ps(rDotv, _mm_setzero_ps()));
+    spec = _mm_and_ps(hasSpec, spec);
+
+    __m128 diffuse = _mm_add_ps(_mm_set1_ps(AMBIENT_TERM), lDotn);
+    _mm_store_ps(&b.r[k], _mm_add_ps(_mm_mul_ps(diffuse, _mm_load_ps(&b.cr[k])), spec));
+    _mm_store_ps(&b.g[k], _mm_add_ps(_mm_mul_ps(diffuse, _mm_load_ps(&b.cg[k])), spec));
+    _mm_store_ps(&b.b[k], _mm_add_ps(_mm_mul_ps(diffuse, _mm_load_ps(&b.cb[k])), spec));
+}
+#endif
+
+/**
+* Computes the colour given by SceneObject::lighting() for every hit
+* of the batch, without shadows.  colors[k] is the colour of hits[k].
+*/
+void shadeBatch(glm::vec3 lightPos, std::vector<HitRecord>& hits,
+                std::vector<SceneObject*>& sceneObjects, std::vector<glm::vec3>& colors)
+{
+    HitBatch b;
+    colors.resize(hits.size());
+#if defined(__SSE2__)
+    __m128 lx = _mm_set1_ps(lightPos.x);
+    __m128 ly = _mm_set1_ps(lightPos.y);
+    __m128 lz = _mm_set1_ps(lightPos.z);
+#endif
+
+    for (size_t first = 0; first < hits.size(); first += CHUNK)
+    {
+        int n = (int)std::min(hits.size() - first, (size_t)CHUNK);
+        int padded = (n + 3) & ~3;
+        b.maxExpo = 0;
+
+        for (int k = 0; k < padded; k++)
+        {
+            if (k >= n)
+            {
+                b.px[k] = lightPos.x - 1;  b.py[k] = lightPos.y;  b.pz[k] = lightPos.z;
+                b.nx[k] = b.ny[k] = b.nz[k] = 0;
+                b.vx[k] = b.vy[k] = b.vz[k] = 0;
+                b.cr[k] = b.cg[k] = b.cb[k] = 0;
+                b.shin[k] = 0;
+                b.expo[k] = 0;
+                continue;
+            }
+            HitRecord& h = hits[first + k];
+            SceneObject* obj = sceneObjects[h.index];
+            b.px[k] = h.pos.x;    b.py[k] = h.pos.y;    b.pz[k] = h.pos.z;
+            b.nx[k] = h.normal.x; b.ny[k] = h.normal.y; b.nz[k] = h.normal.z;
+            b.vx[k] = h.view.x;   b.vy[k] = h.view.y;   b.vz[k] = h.view.z;
+            b.cr[k] = h.color.r;  b.cg[k] = h.color.g;  b.cb[k] = h.color.b;
+            b.shin[k] = 0;
+            b.expo[k] = 0;
+            if (obj->isSpecular())
+            {
+                float shin = obj->getShininess();
+                b.shin[k] = shin;
+                if (shin == floor(shin) && shin >= 1 && shin <= MAX_INT_SHININESS) b.expo[k] = (int)shin;
+                if (b.expo[k] > b.maxExpo) b.maxExpo = b.expo[k];
+            }
+        }
+
+        int k = 0;
+#if defined(__SSE2__)
+        for (; k < padded; k += 4) shadeFour(lx, ly, lz, b, k);
+#endif
+        for (int m = 0; m < n; m++)
+        {
+            //Lanes the vector path could not handle, and every lane without SSE2
+            if (m >= k || (b.shin[m] > 0 && b.expo[m] == 0)) shadeScalar(lightPos, b, m);
+            colors[first + m] = glm::vec3(b.r[m], b.g[m], b.b[m]);
+        }
+    }
+}
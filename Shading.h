@@ -0,0 +1,33 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Batched Phong shading
+*  Evaluates the ambient, diffuse and specular terms of
+*  SceneObject::lighting() for a batch of hits at once,
+*  four hits per SSE instruction.
+-------------------------------------------------------------*/
+
+#ifndef H_SHADING
+#define H_SHADING
+#include <glm/glm.hpp>
+#include <vector>
+#include "SceneObject.h"
+
+/**
+ * A point of intersection waiting to be shaded.
+ * index selects the object whose shininess and
+ * specularity apply.
+ */
+struct HitRecord
+{
+    glm::vec3 pos;      //Point of intersection
+    glm::vec3 normal;   //Unit normal at pos
+    glm::vec3 view;     //Unit vector from pos towards the viewer
+    glm::vec3 color;    //Surface colour at pos
+    int index;          //Index of the object in the scene
+};
+
+void shadeBatch(glm::vec3 lightPos, std::vector<HitRecord>& hits,
+                std::vector<SceneObject*>& sceneObjects, std::vector<glm::vec3>& colors);
+
+#endif //!H_SHADING
@@ -0,0 +1,125 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shadow cache class
+-------------------------------------------------------------*/
+
+#include "ShadowCache.h"
+#include <math.h>
+
+const int MIN_SAMPLES = 2;      //Agreeing shadow rays needed before a cell is trusted
+const int TABLE_BITS = 12;      //The table holds 2^TABLE_BITS cells
+
+ShadowCache::ShadowCache(float tolerance) : tolerance_(tolerance)
+{
+    cells_.resize(1 << TABLE_BITS);
+    clear();
+}
+
+/**
+* Hash key of the cell containing 'pos', offset by (dx, dy, dz) cells,
+* for surfaces facing roughly along 'normal'.  The normal is quantised
+* so that the two sides of a thin object never share a cell.
+*/
+uint64_t ShadowCache::key(glm::vec3 pos, glm::vec3 normal, int dx, int dy, int dz)
+{
+    int64_t ix = (int64_t)floor(pos.x / tolerance_) + dx;
+    int64_t iy = (int64_t)floor(pos.y / tolerance_) + dy;
+    int64_t iz = (int64_t)floor(pos.z / tolerance_) + dz;
+    int nx = (int)floor(normal.x * 1.5f + 1.5f);     //0..3 per component
+    int ny = (int)floor(normal.y * 1.5f + 1.5f);
+    int nz = (int)floor(normal.z * 1.5f + 1.5f);
+
+    uint64_t k = (uint64_t)(ix & 0x1FFFFF);
+    k = (k << 16) | (uint64_t)(iy & 0xFFFF);
+    k = (k << 21) | (uint64_t)(iz & 0x1FFFFF);
+    k = (k << 6) | (uint64_t)((nx & 3) << 4 | (ny & 3) << 2 | (nz & 3));
+    return k | 1;       //Never 0, which marks an empty slot
+}
+
+//Slot of cell k if the cell is in the table, otherwise null
+ShadowCache::Entry* ShadowCache::find(uint64_t k)
+{
+    Entry& e = cells_[(k * 0x9E3779B97F4A7C15ull) >> (64 - TABLE_BITS)];
+    return (e.key == k) ? &e : nullptr;
+}
+
+/**
+* Returns true, with the cached occluder and its colour, if the shadow
+* ray from 'pos' need not be traced.
+*/
+bool ShadowCache::lookup(glm::vec3 pos, glm::vec3 normal, int& occluder, glm::vec3& color)
+{
+    const int offsets[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+    Entry* e = find(key(pos, normal, 0, 0, 0));
+    if (e == nullptr || e->mixed || e->count < MIN_SAMPLES)
+    {
+        misses_++;
+        return false;
+    }
+
+    for (int k = 0; k < 6; k++)
+    {
+        Entry* nb = find(key(pos, normal, offsets[k][0], offsets[k][1], offsets[k][2]));
+        if (nb != nullptr && (nb->mixed || nb->occluder != e->occluder))
+        {
+            misses_++;
+            return false;
+        }
+    }
+
+    occluder = e->occluder;
+    color = e->color;
+    hits_++;
+    return true;
+}
+
+/**
+* Returns true if the cell of 'pos' and its six neighbours hold at least
+* MIN_SAMPLES shadow rays between them, and every one found 'occluder'.
+* Unlike lookup(), the cell itself may be empty.
+*/
+bool ShadowCache::agrees(glm::vec3 pos, glm::vec3 normal, int occluder)
+{
+    const int offsets[7][3] = {{0, 0, 0}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+    int count = 0;
+    for (int k = 0; k < 7; k++)
+    {
+        Entry* e = find(key(pos, normal, offsets[k][0], offsets[k][1], offsets[k][2]));
+        if (e == nullptr) continue;
+        if (e->mixed || e->occluder != occluder) return false;
+        count += e->count;
+    }
+    return count >= MIN_SAMPLES;
+}
+
+//Records the result of a shadow ray traced from 'pos'
+void ShadowCache::record(glm::vec3 pos, glm::vec3 normal, int occluder, glm::vec3 color)
+{
+    uint64_t k = key(pos, normal, 0, 0, 0);
+    Entry& e = cells_[(k * 0x9E3779B97F4A7C15ull) >> (64 - TABLE_BITS)];
+    if (e.key != k)
+    {
+        e = {k, occluder, color, 1, false};
+        return;
+    }
+    if (e.occluder != occluder) e.mixed = true;
+    e.count++;
+}
+
+void ShadowCache::clear()
+{
+    for (Entry& e : cells_) e.key = 0;
+}
+
+long ShadowCache::getHits()
+{
+    return hits_;
+}
+
+long ShadowCache::getMisses()
+{
+    return misses_;
+}
@@ -0,0 +1,54 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shadow cache class
+*  Remembers the result of shadow rays cast from diffuse
+*  surfaces, keyed on a spatial hash of the hit position
+*  (in cells of side 'tolerance') and of its normal.  A
+*  cached result is only reused when at least two shadow
+*  rays in the cell agreed and no neighbouring cell
+*  disagrees, so visibility can only be wrong within one
+*  cell of a shadow edge.  The table has a fixed size, so
+*  memory stays bounded however many points are shaded.
+*  A cache is used by one thread.
+-------------------------------------------------------------*/
+
+#ifndef H_SHADOWCACHE
+#define H_SHADOWCACHE
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class ShadowCache
+{
+private:
+    struct Entry
+    {
+        uint64_t key;           //Cell held by this slot; 0 if empty
+        int occluder;           //Index of the object blocking the light, or -1
+        glm::vec3 color;        //Colour of the occluder where the shadow ray hit it
+        int count;              //Shadow rays recorded in the cell
+        int mixed;              //True if they disagreed
+    };
+
+    std::vector<Entry> cells_;      //Direct-mapped: a new cell replaces the one in its slot
+    float tolerance_;
+    long hits_ = 0;
+    long misses_ = 0;
+
+    uint64_t key(glm::vec3 pos, glm::vec3 normal, int dx, int dy, int dz);
+    Entry* find(uint64_t k);
+
+public:
+    ShadowCache(float tolerance);
+
+    bool lookup(glm::vec3 pos, glm::vec3 normal, int& occluder, glm::vec3& color);
+    bool agrees(glm::vec3 pos, glm::vec3 normal, int occluder);
+    void record(glm::vec3 pos, glm::vec3 normal, int occluder, glm::vec3 color);
+    void clear();
+
+    long getHits();
+    long getMisses();
+};
+
+#endif //!H_SHADOWCACHE
@@ -0,0 +1,140 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shared framebuffer class
+-------------------------------------------------------------*/
+
+#include "SharedFramebuffer.h"
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory needs lock-free atomics");
+
+SharedFramebuffer::~SharedFramebuffer()
+{
+    close();
+}
+
+/**
+* Bytes of the segment for an image, and in headerBytes the offset of its
+* pixels, which start on a cache line.
+*/
+size_t SharedFramebuffer::segmentSize(int width, int height, int tileSize, FramebufferFormat format, size_t& headerBytes)
+{
+    int tiles = ((width + tileSize - 1) / tileSize) * ((height + tileSize - 1) / tileSize);
+    size_t bitmapWords = (tiles + 31) / 32;
+    headerBytes = offsetof(FramebufferHeader, bitmap) + bitmapWords * sizeof(uint32_t);
+    headerBytes = (headerBytes + 63) / 64 * 64;
+    size_t pixelBytes = (format == FB_RGB32F) ? 3 * sizeof(float) : 3;
+    return headerBytes + pixelBytes * width * height;
+}
+
+//---Creates (or reuses) the segment 'name', such as "/raytracer", for an image -----------
+//   The render's tiles must be a whole number of framebuffer tiles (tileSize
+//     dividing RenderSettings::tileSize).  The first frame is begun.
+//----------------------------------------------------------------------------------
+bool SharedFramebuffer::open(const char* name, int width, int height, int tileSize, FramebufferFormat format)
+{
+    close();
+    size_t headerBytes;
+    size_t size = segmentSize(width, height, tileSize, format, headerBytes);
+
+    fd_ = shm_open(name, O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0 || ftruncate(fd_, size) != 0 ||
+        (memory_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)) == MAP_FAILED)
+    {
+        std::cout << "*** Error opening shared framebuffer: " << name << std::endl;
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        memory_ = nullptr;
+        return false;
+    }
+    size_ = size;
+
+    header_ = (FramebufferHeader*)memory_;
+    header_->frame.store(header_->frame.load() | 1);       //Readers of an earlier frame see it change
+    header_->width = width;
+    header_->height = height;
+    header_->format = format;
+    header_->tileSize = tileSize;
+    header_->tilesX = (width + tileSize - 1) / tileSize;
+    header_->tilesY = (height + tileSize - 1) / tileSize;
+    header_->bitmapWords = (header_->tilesX * header_->tilesY + 31) / 32;
+    header_->headerBytes = (uint32_t)headerBytes;
+    memcpy(header_->magic, FRAMEBUFFER_MAGIC, sizeof(FRAMEBUFFER_MAGIC));
+    pixels_ = (unsigned char*)memory_ + headerBytes;
+
+    beginFrame();
+    return true;
+}
+
+/**
+* Starts a new frame: no tiles are finished.  Pixels keep the last frame's
+* values until overwritten.  Must not overlap write().
+*/
+void SharedFramebuffer::beginFrame()
+{
+    if (header_ == nullptr) return;
+    uint64_t frame = header_->frame.load();
+    if (frame % 2 == 0) header_->frame.store(++frame);
+    for (uint32_t w = 0; w < header_->bitmapWords; w++) header_->bitmap[w].store(0, std::memory_order_relaxed);
+    header_->tilesDone.store(0, std::memory_order_relaxed);
+    header_->frame.store(frame + 1, std::memory_order_release);
+}
+
+//Copies a finished tile into the segment, then marks it finished
+void SharedFramebuffer::write(Tile& tile, Image& pixels)
+{
+    if (header_ == nullptr) return;
+    int width = header_->width;
+    for (int j = tile.y0; j < tile.y1; j++)
+    {
+        if (header_->format == FB_RGB32F)
+        {
+            float* row = (float*)pixels_ + 3L * (width * j + tile.x0);
+            for (int i = tile.x0; i < tile.x1; i++, row += 3)
+                memcpy(row, &pixels.at(i, j), 3 * sizeof(float));
+        }
+        else
+        {
+            unsigned char* row = pixels_ + 3L * (width * j + tile.x0);
+            for (int i = tile.x0; i < tile.x1; i++)
+            {
+                glm::vec3& col = pixels.at(i, j);
+                *row++ = Image::toByte(col.r);
+                *row++ = Image::toByte(col.g);
+                *row++ = Image::toByte(col.b);
+            }
+        }
+    }
+
+    //Every framebuffer tile starting inside the tile is now complete
+    int size = header_->tileSize;
+    for (int ty = (tile.y0 + size - 1) / size; ty * size < tile.y1; ty++)
+        for (int tx = (tile.x0 + size - 1) / size; tx * size < tile.x1; tx++)
+        {
+            int t = ty * header_->tilesX + tx;
+            header_->bitmap[t / 32].fetch_or(1u << (t % 32), std::memory_order_release);
+            header_->tilesDone.fetch_add(1, std::memory_order_release);
+        }
+}
+
+//Unmaps the segment, which stays for readers until remove()
+void SharedFramebuffer::close()
+{
+    if (memory_ != nullptr) munmap(memory_, size_);
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    memory_ = nullptr;
+    header_ = nullptr;
+    size_ = 0;
+}
+
+bool SharedFramebuffer::remove(const char* name)
+{
+    return shm_unlink(name) == 0;
+}
@@ -0,0 +1,78 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shared framebuffer class
+*  A TileSink that writes a render into POSIX shared memory
+*  (shm_open), where other processes can map it and show
+*  tiles as they finish, without copies or files.  The
+*  segment holds a FramebufferHeader, a bitmap of finished
+*  tiles, then the pixels from headerBytes on: row 0 is
+*  the bottom row, and each pixel is RGB in the header's
+*  format.  The segment stays after close(), so viewers
+*  can still read the last frame; remove() deletes it.
+*
+*  A reader takes frame, then a tile's bit, then the tile's
+*  pixels, then frame again.  The pixels are good if the
+*  bit was set, frame was even and it did not change.
+-------------------------------------------------------------*/
+
+#ifndef H_SHAREDFRAMEBUFFER
+#define H_SHAREDFRAMEBUFFER
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "TileSink.h"
+
+enum FramebufferFormat
+{
+    FB_RGB8 = 1,        //3 bytes per pixel, 0 to 255
+    FB_RGB32F = 2       //3 floats per pixel, as rendered (not clamped)
+};
+
+const char FRAMEBUFFER_MAGIC[8] = {'R', 'T', 'F', 'R', 'A', 'M', 'E', '1'};
+
+/**
+ * Start of the shared segment.  Tile t covers the cells of tile column
+ * t % tilesX and row t / tilesX, tileSize cells on a side (fewer at the
+ * right and top edges); its bit is bit t % 32 of bitmap word t / 32.
+ */
+struct FramebufferHeader
+{
+    char magic[8];                      //FRAMEBUFFER_MAGIC
+    uint32_t headerBytes;               //Offset of the pixels
+    int32_t width, height;
+    int32_t format;                     //FramebufferFormat
+    int32_t tileSize;
+    int32_t tilesX, tilesY;
+    uint32_t bitmapWords;
+    std::atomic<uint64_t> frame;        //Odd while a new frame is set up; frame / 2 counts frames
+    std::atomic<uint32_t> tilesDone;    //Tiles of this frame finished
+    std::atomic<uint32_t> bitmap[1];    //bitmapWords words in all
+};
+
+class SharedFramebuffer : public TileSink
+{
+private:
+    int fd_ = -1;
+    void* memory_ = nullptr;
+    size_t size_ = 0;
+    FramebufferHeader* header_ = nullptr;
+    unsigned char* pixels_ = nullptr;
+
+public:
+    SharedFramebuffer() = default;
+    ~SharedFramebuffer();
+
+    SharedFramebuffer(const SharedFramebuffer&) = delete;
+    SharedFramebuffer& operator=(const SharedFramebuffer&) = delete;
+
+    bool open(const char* name, int width, int height, int tileSize, FramebufferFormat format = FB_RGB8);
+    void beginFrame();
+    void write(Tile& tile, Image& pixels);
+    void close();
+
+    static bool remove(const char* name);
+    static size_t segmentSize(int width, int height, int tileSize, FramebufferFormat format, size_t& headerBytes);
+};
+
+#endif //!H_SHAREDFRAMEBUFFER
@@ -7,6 +7,7 @@
 -------------------------------------------------------------*/
 
 #include "Sphere.h"
+#include "Quadric.h"
 #include <math.h>
 
 /**
@@ -32,6 +33,25 @@ float Sphere::intersect(glm::vec3 p0, glm::vec3 dir)
 	else return t1;
 }
 
+/**
+* Both roots of the intersection: the ray is inside the sphere between them.
+* They are the values intersect() chooses from.
+*/
+bool Sphere::interval(glm::vec3 p0, glm::vec3 dir, float& tEntry, float& tExit)
+{
+    glm::vec3 vdif = p0 - center;
+    float b = glm::dot(dir, vdif);
+    float len = glm::length(vdif);
+    float c = len*len - radius*radius;
+    float delta = b*b - c;
+
+    if(delta < 0.001) return false;
+
+    tEntry = -b - sqrt(delta);
+    tExit = -b + sqrt(delta);
+    return true;
+}
+
 /**
 * Returns the unit normal vector at a given point.
 * Assumption: The input point p lies on the sphere.
@@ -42,3 +62,27 @@ glm::vec3 Sphere::normal(glm::vec3 p)
     n = glm::normalize(n);
     return n;
 }
+
+/**
+* Returns the bounding box of the sphere.
+*/
+void Sphere::bounds(glm::vec3& lo, glm::vec3& hi)
+{
+    lo = center - glm::vec3(radius);
+    hi = center + glm::vec3(radius);
+}
+
+SceneObject* Sphere::clone()
+{
+    return new Sphere(*this);
+}
+
+bool Sphere::quadric(Quadric& q)
+{
+    q.shape = QUADRIC_SPHERE;
+    q.centre = center;
+    q.radius = radius;
+    q.height = 0;
+    q.cap = false;
+    return true;
+}
@@ -0,0 +1,99 @@
+/*==================================================================================
+* COSC 363  Computer Graphics
+* Department of Computer Science and Software Engineering, University of Canterbury.
+*
+* Stress benchmark
+* Renders stress scenes (see createStressScene()) of 1, 10, 100, ... objects up
+* to a maximum, each on 1, 2, 4, ... threads up to a maximum, to show where the
+* renderer stops scaling with scene size and cores.  Prints CSV, one line per
+* render: the times to make the scene and build its BVH, the BVH's memory, the
+* process's resident memory, and the render's time, rays (trace() calls:
+* primary and secondary rays, not shadow rays) and rays per second, with the
+* speed-up and parallel efficiency over one thread.
+*
+* Usage:  StressBench.out [max objects] [max threads] [resolution]
+*                         [reflective] [refractive] [transparent]
+*===================================================================================
+*/
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "Renderer.h"
+using namespace std;
+
+static double millisSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+//Resident memory now and at most so far, in MB
+static void residentMB(double& now, double& peak)
+{
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm != nullptr)
+    {
+        if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(statm);
+    }
+    now = resident * (double)sysconf(_SC_PAGESIZE) / 1048576.0;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    peak = usage.ru_maxrss / 1024.0;
+}
+
+int main(int argc, char* argv[])
+{
+    long maxObjects = (argc > 1) ? atol(argv[1]) : 100000;
+    int maxThreads = (argc > 2) ? atoi(argv[2]) : max(1, (int)thread::hardware_concurrency());
+    int resolution = (argc > 3) ? atoi(argv[3]) : 256;
+    StressSceneParams params;
+    if (argc > 4) params.reflective = atof(argv[4]);
+    if (argc > 5) params.refractive = atof(argv[5]);
+    if (argc > 6) params.transparent = atof(argv[6]);
+
+    cout << "objects,threads,scene_ms,build_ms,bvh_mb,rss_mb,peak_rss_mb,render_ms,rays,rays_per_sec,speedup,efficiency"
+         << endl;
+    for (long count = 1; count <= maxObjects; count *= 10)
+    {
+        params.objects = count;
+        auto start = chrono::steady_clock::now();
+        shared_ptr<Scene> scene = createStressScene(params);
+        double sceneMs = millisSince(start);
+        scene->buildBVH(BVH_SAH, maxThreads);
+        BVHStats stats = scene->getBVHStats();
+
+        double oneThreadRate = 0;
+        for (int threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            RenderSettings settings;
+            settings.resolution = resolution;
+            settings.antiAliasing = false;      //The same rays on any number of threads
+            settings.fog = false;
+            settings.threads = threads;
+            Image costs(resolution, resolution);
+            settings.costImage = &costs;
+
+            start = chrono::steady_clock::now();
+            render(*scene, Camera(), settings);
+            double renderMs = millisSince(start);
+
+            double rays = 0;
+            for (int j = 0; j < resolution; j++)
+                for (int i = 0; i < resolution; i++) rays += costs.at(i, j)[COST_TRACES];
+            double rate = rays / (renderMs / 1000);
+            if (threads == 1) oneThreadRate = rate;
+            double rss, peakRss;
+            residentMB(rss, peakRss);
+
+            cout << count << ',' << threads << ',' << sceneMs << ',' << stats.buildMs << ','
+                 << stats.bytes / 1048576.0 << ',' << rss << ',' << peakRss << ',' << renderMs << ','
+                 << (long)rays << ',' << (long)rate << ',' << rate / oneThreadRate << ','
+                 << rate / oneThreadRate / threads << endl;
+        }
+    }
+    return 0;
+}
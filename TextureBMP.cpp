@@ -68,8 +68,8 @@ bool TextureBMP::loadBMPImage(const char* filename)
 
     nbytes = bpp / 8;           //No. of bytes per pixels
     size = wid * hgt * nbytes;  //Total number of bytes to be read
-    imageData = new char[size];
-    file.read(imageData, size);
+    imageData.resize(size);
+    file.read(imageData.data(), size);
     if(nbytes > 2)   //swap R and B
     {
         for(int i = 0; i < wid*hgt;  i++)
@@ -12,6 +12,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include <glm/glm.hpp>
 using namespace std;
 
@@ -19,7 +20,7 @@ class TextureBMP
 {
     private:
         int imageWid, imageHgt, imageChnls;  //Width, height, number of channels
-        char* imageData;
+        vector<char> imageData;
         bool loadBMPImage(const char* string);
     public:
 		TextureBMP(): imageWid(0), imageHgt(0), imageChnls(0) {}
@@ -0,0 +1,56 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The thread pool class
+-------------------------------------------------------------*/
+
+#include "ThreadPool.h"
+
+//Starts 'threads' workers, or one per hardware thread if threads <= 0
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    for (int k = 0; k < threads; k++) workers_.push_back(std::thread(&ThreadPool::run, this));
+}
+
+//Finishes the queued tasks, then stops the workers
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    ready_.notify_all();
+    for (std::thread& t : workers_) t.join();
+}
+
+void ThreadPool::submit(int priority, std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push({priority, seq_++, fn});
+    }
+    ready_.notify_one();
+}
+
+int ThreadPool::size()
+{
+    return (int)workers_.size();
+}
+
+void ThreadPool::run()
+{
+    for (;;)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            task = queue_.top();
+            queue_.pop();
+        }
+        task.fn();
+    }
+}
@@ -0,0 +1,55 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The thread pool class
+*  A fixed set of worker threads shared by any number of
+*  renders.  Tasks with a higher priority run first; tasks
+*  of equal priority run in the order they were submitted.
+-------------------------------------------------------------*/
+
+#ifndef H_THREADPOOL
+#define H_THREADPOOL
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+private:
+    struct Task
+    {
+        int priority;
+        long seq;
+        std::function<void()> fn;
+
+        bool operator<(const Task& other) const
+        {
+            if (priority != other.priority) return priority < other.priority;
+            return seq > other.seq;
+        }
+    };
+
+    std::priority_queue<Task> queue_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<std::thread> workers_;
+    long seq_ = 0;
+    bool stop_ = false;
+
+    void run();
+
+public:
+    ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(int priority, std::function<void()> fn);
+    int size();
+};
+
+#endif //!H_THREADPOOL
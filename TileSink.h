@@ -0,0 +1,33 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Tiles and tile sinks
+*  A render is split into tiles, and every finished tile is
+*  handed to a TileSink, which may copy it into a complete
+*  image or write it straight to a file.  write() is called
+*  from the render's worker threads, possibly several at
+*  once, and only for tiles that were rendered in full.
+-------------------------------------------------------------*/
+
+#ifndef H_TILESINK
+#define H_TILESINK
+#include "Image.h"
+
+/**
+ * A rectangle of cells [x0, x1) x [y0, y1).
+ */
+struct Tile
+{
+    int x0, y0, x1, y1;
+};
+
+class TileSink
+{
+public:
+    virtual ~TileSink() {}
+
+    //pixels covers exactly the tile: pixels.at(i, j) for x0 <= i < x1, y0 <= j < y1
+    virtual void write(Tile& tile, Image& pixels) = 0;
+};
+
+#endif //!H_TILESINK